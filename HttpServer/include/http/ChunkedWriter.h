@@ -0,0 +1,64 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <muduo/net/Buffer.h>
+
+namespace http
+{
+
+// 流式响应体的写入器：每次 write 追加一个 chunked 帧，HTTP/1.0 客户端不支持 chunked，
+// 此时直接写原始数据，由关闭连接标记响应结束
+class ChunkedWriter
+{
+public:
+    ChunkedWriter(muduo::net::Buffer* output, bool chunked)
+        : output_(output)
+        , chunked_(chunked)
+        , bytesWritten_(0)
+    {}
+
+    void write(const char* data, size_t len);
+
+    void write(const std::string& data)
+    { write(data.data(), data.size()); }
+
+    // 结束响应体：chunked 模式下追加长度为 0 的结束帧
+    void finish();
+
+    // 已写入的响应体字节数（不含帧头）
+    size_t bytesWritten() const
+    { return bytesWritten_; }
+
+    // 生产函数返回 ChunkedStatus::kWouldBlock 之前取出这个函数保存起来，
+    // 数据就绪后在任意线程调用它，响应体会在连接所属的 IO 线程中继续生成
+    const std::function<void ()>& resumer() const
+    { return resume_; }
+
+    void setResumer(std::function<void ()> resume)
+    { resume_ = std::move(resume); }
+
+private:
+    muduo::net::Buffer*    output_;
+    bool                   chunked_;
+    size_t                 bytesWritten_;
+    std::function<void ()> resume_;
+};
+
+// 流式响应体生产函数的返回值
+enum class ChunkedStatus
+{
+    kMore,       // 后面还有数据
+    kDone,       // 响应体结束
+    kWouldBlock, // 暂时没有数据（如在等上游），调用 resumer() 之前不会再被调用
+};
+
+// 流式响应体的生产函数：在连接所属的 IO 线程中被反复调用，每次写一段数据。
+// 只有输出缓冲区排空后才会被再次调用，每轮生成的数据不超过连接的输出高水位，
+// 因此生成速度自动跟随客户端的读取速度，不会在内存里攒下整个响应体。
+// 返回 kMore 却没有写出数据时本轮立即结束，让出 IO 线程后再调用；
+// 等待外部数据时应返回 kWouldBlock，而不是反复空返回
+using ChunkedBodyCallback = std::function<ChunkedStatus (ChunkedWriter*)>;
+
+} // namespace http
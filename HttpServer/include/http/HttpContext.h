@@ -1,14 +1,35 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
+#include <memory>
 
 #include <muduo/net/TcpServer.h>
 
+#include "ChunkedWriter.h"
 #include "HttpRequest.h"
+#include "TimingWheel.h"
+#include "../utils/FileCache.h"
 
 namespace http
 {
 
+namespace router
+{
+struct Route;
+} // namespace router
+
+// 请求体的接收策略，由 HttpServer 持有，所有连接共享
+struct BodyOptions
+{
+    size_t      maxBodyBytes = 64 * 1024 * 1024; // 请求体上限，超过回复 413
+    size_t      spillBytes = 1024 * 1024; // 请求体超过这个大小后写入临时文件
+    std::string spillDir = "/tmp"; // 临时文件所在目录
+    // 带请求体的请求在请求头收完后匹配路由（同时填好路径参数），路由上注册了增量回调时请求体交给它；
+    // 匹配结果留在 HttpContext 上供分发时直接使用，不再匹配第二次
+    std::function<const router::Route* (HttpRequest&)> matchRoute;
+};
+
 class HttpContext 
 {
 public:
@@ -19,33 +40,262 @@ public:
         kExpectBody, // 解析请求体
         kGotAll, // 解析完成
     };
+
+    // chunked 请求体内部的解析状态
+    enum ChunkParseState
+    {
+        kChunkSize, // 块大小行
+        kChunkData, // 块数据
+        kChunkDataEnd, // 块数据后的 \r\n
+        kChunkTrailer, // 最后一个块之后的 trailer 和结尾空行
+    };
+
+    // 连接当前挂在时间轮上的超时类型
+    enum IdlePhase
+    {
+        kIdleNone, // 不计时（请求在工作线程池中处理）
+        kIdleHeader, // 接收请求行和请求头，从开始接收起计时，不因陆续到达的字节延长
+        kIdleBody, // 接收请求体，每次读到数据刷新
+        kIdleKeepAlive, // 两个请求之间空闲，或等待客户端读走响应
+    };
     
-    HttpContext()
+    explicit HttpContext(int sockfd = -1, const BodyOptions* bodyOptions = nullptr)
     : state_(kExpectRequestLine)
+    , pending_(false)
+    , sockfd_(sockfd)
+    , fileOffset_(0)
+    , fileRemaining_(0)
+    , closeAfterBody_(false)
+    , streamChunked_(false)
+    , streamWaiting_(false)
+    , streamGeneration_(0)
+    , idleWheel_(nullptr)
+    , idlePhase_(kIdleNone)
+    , backpressured_(false)
+    , reportedOutputBytes_(0)
+    , parseNanos_(0)
+    , bodyOptions_(bodyOptions)
+    , route_(nullptr)
+    , routeMatched_(false)
+    , bodyChunked_(false)
+    , chunkState_(kChunkSize)
+    , bodyRemaining_(0)
+    , bodyReceived_(0)
+    , errorStatus_(0)
+    , scanOffset_(0)
     {}
 
     bool parseRequest(muduo::net::Buffer* buf, muduo::Timestamp receiveTime);
     bool gotAll() const 
     { return state_ == kGotAll;  }
 
+    bool expectingHeaders() const
+    { return state_ == kExpectHeaders; }
+
+    bool expectingBody() const
+    { return state_ == kExpectBody; }
+
+    // parseRequest 返回 false 时应回复的状态码：400，请求体超限时为 413，落盘失败时为 500
+    int errorStatus() const
+    { return errorStatus_; }
+
+    // 当前请求累计的解析耗时
+    uint64_t parseNanos() const
+    { return parseNanos_; }
+
     void reset()
     {
         state_ = kExpectRequestLine;
-        HttpRequest dummyData;
-        request_.swap(dummyData);
+        parseNanos_ = 0;
+        bodySink_ = nullptr;
+        route_ = nullptr;
+        routeMatched_ = false;
+        bodyChunked_ = false;
+        chunkState_ = kChunkSize;
+        bodyRemaining_ = 0;
+        bodyReceived_ = 0;
+        errorStatus_ = 0;
+        scanOffset_ = 0;
+        // 保留请求对象已分配的容量，下一个请求直接复用
+        request_.clear();
     }
 
+    // 收请求体之前是否已经匹配过路由，匹配过时 matchedRoute() 就是结果（可能为 nullptr）
+    bool routeMatched() const
+    { return routeMatched_; }
+
+    const router::Route* matchedRoute() const
+    { return route_; }
+
+    // 连接上唯一的请求对象：解析、中间件、缓存、路由和处理器都直接使用它，不做拷贝；
+    // reset() 后在下一个 keep-alive 请求上复用，阻塞型请求在工作线程处理完成后才 reset
     const HttpRequest& request() const
     { return request_;}
 
     HttpRequest& request()
     { return request_;}
 
+    // 是否有请求正在工作线程池中处理；处理完成前不再解析后续的流水线请求，保证响应顺序
+    bool pending() const
+    { return pending_; }
+
+    void setPending(bool on)
+    { pending_ = on; }
+
+    // 连接的 socket fd，sendfile 直接写它
+    int sockfd() const
+    { return sockfd_; }
+
+    // 正在发送的文件响应体；发送完成前同样暂停解析后续请求
+    void setFileBody(CachedFilePtr file, bool closeAfter)
+    {
+        fileRemaining_ = file->size();
+        fileOffset_ = 0;
+        file_ = std::move(file);
+        closeAfterBody_ = closeAfter;
+        pending_ = true;
+    }
+
+    void clearFileBody()
+    {
+        file_.reset();
+        fileOffset_ = 0;
+        fileRemaining_ = 0;
+        pending_ = false;
+    }
+
+    bool sendingFile() const
+    { return file_ != nullptr; }
+
+    const CachedFilePtr& file() const
+    { return file_; }
+
+    off_t* fileOffset()
+    { return &fileOffset_; }
+
+    size_t& fileRemaining()
+    { return fileRemaining_; }
+
+    // 正在发送的流式响应体；和文件响应体一样，发送完成前暂停解析后续请求
+    void setChunkedBody(ChunkedBodyCallback stream, bool chunked, bool closeAfter)
+    {
+        stream_ = std::move(stream);
+        streamChunked_ = chunked;
+        streamWaiting_ = false;
+        ++streamGeneration_;
+        closeAfterBody_ = closeAfter;
+        pending_ = true;
+    }
+
+    void clearChunkedBody()
+    {
+        stream_ = nullptr;
+        streamWaiting_ = false;
+        pending_ = false;
+    }
+
+    bool sendingChunked() const
+    { return static_cast<bool>(stream_); }
+
+    const ChunkedBodyCallback& chunkedBody() const
+    { return stream_; }
+
+    bool streamChunked() const
+    { return streamChunked_; }
+
+    // 生产函数返回了 kWouldBlock，在等它调用 resumer
+    bool streamWaiting() const
+    { return streamWaiting_; }
+
+    void setStreamWaiting(bool on)
+    { streamWaiting_ = on; }
+
+    // 每个流式响应体一个编号，长连接上迟到的 resumer 调用据此识别出已经结束的旧响应
+    uint64_t streamGeneration() const
+    { return streamGeneration_; }
+
+    // 文件或流式响应体还没发完
+    bool sendingBody() const
+    { return sendingFile() || sendingChunked(); }
+
+    // 文件或流式响应体发完后是否关闭连接
+    bool closeAfterBody() const
+    { return closeAfterBody_; }
+
+    // 连接所在 IO 线程的时间轮，未开启空闲超时时为空
+    TimingWheel* idleWheel() const
+    { return idleWheel_; }
+
+    void setIdleWheel(TimingWheel* wheel)
+    { idleWheel_ = wheel; }
+
+    IdlePhase idlePhase() const
+    { return idlePhase_; }
+
+    IdleEntryPtr idleEntry() const
+    { return idleEntry_.lock(); }
+
+    void setIdleEntry(IdlePhase phase, const IdleEntryPtr& entry)
+    {
+        idlePhase_ = phase;
+        idleEntry_ = entry;
+    }
+
+    // 输出积压超过高水位后暂停读取，期间不再解析后续的流水线请求
+    bool backpressured() const
+    { return backpressured_; }
+
+    void setBackpressured(bool on)
+    { backpressured_ = on; }
+
+    // 该连接上一次计入全局计数的输出积压字节数
+    size_t reportedOutputBytes() const
+    { return reportedOutputBytes_; }
+
+    void setReportedOutputBytes(size_t bytes)
+    { reportedOutputBytes_ = bytes; }
+
 private:
     bool processRequestLine(const char* begin, const char* end);
+    const char* findLineEnd(const muduo::net::Buffer* buf);
+    bool startBody();
+    bool parseFixedBody(muduo::net::Buffer* buf);
+    bool parseChunkedBody(muduo::net::Buffer* buf);
+    bool consumeBody(const char* data, size_t len);
+    bool fail(int status);
+    const BodyOptions& bodyOptions() const;
 private:
     HttpRequestParseState state_;
     HttpRequest           request_;
+    bool                  pending_;
+    int                   sockfd_;
+    CachedFilePtr         file_; // 正在 sendfile 的文件
+    off_t                 fileOffset_;
+    size_t                fileRemaining_;
+    bool                  closeAfterBody_; // 文件或流式响应体发完后是否关闭连接
+    ChunkedBodyCallback   stream_; // 正在发送的流式响应体
+    bool                  streamChunked_; // false 表示 HTTP/1.0 客户端，直接写原始数据
+    bool                  streamWaiting_;
+    uint64_t              streamGeneration_;
+    TimingWheel*          idleWheel_;
+    IdlePhase             idlePhase_;
+    std::weak_ptr<IdleEntry> idleEntry_; // 条目只由时间轮持有，这里只记着用于刷新和取消
+    bool                  backpressured_;
+    size_t                reportedOutputBytes_;
+    uint64_t              parseNanos_;
+    const BodyOptions*    bodyOptions_; // 为空时使用默认策略
+    const router::Route*  route_; // 收请求体之前匹配到的路由
+    bool                  routeMatched_;
+    BodyDataCallback      bodySink_; // 当前请求的增量回调
+    bool                  bodyChunked_; // 当前请求体是否为 chunked 编码
+    ChunkParseState       chunkState_;
+    size_t                bodyRemaining_; // Content-Length 或当前块还没收到的字节数
+    size_t                bodyReceived_; // 已收到的请求体字节数
+    int                   errorStatus_;
+    size_t                scanOffset_; // 当前行已经扫描过、确认没有 \r\n 的字节数
 };
 
+// HttpRequest 只能移动，连接上下文不能拷贝，TcpConnection 的 context 里保存的是指针
+using HttpContextPtr = std::shared_ptr<HttpContext>;
+
 } // namespace http
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <muduo/base/StringPiece.h>
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+// 每个线程缓存一份格式化好的 "Date: ...\r\n" 头部行，避免每个响应都格式化时间
+// IO 线程通过 startTicking 每秒刷新一次；其它线程（如工作线程）在读取时按秒懒刷新
+class HttpDate
+{
+public:
+    // 必须在 loop 所在线程中调用
+    static void startTicking(muduo::net::EventLoop* loop);
+
+    // 当前线程缓存的 Date 头部行，包含结尾的 \r\n
+    static muduo::StringPiece headerLine();
+
+private:
+    static void refresh();
+};
+
+} // namespace http
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+namespace http
+{
+
+// 常用请求头：HttpRequest 为每个常用头部留一个固定槽位，按枚举值 O(1) 读取
+enum KnownHeader
+{
+    kHeaderHost,
+    kHeaderConnection,
+    kHeaderContentLength,
+    kHeaderContentType,
+    kHeaderTransferEncoding,
+    kHeaderCookie,
+    kHeaderAuthorization,
+    kHeaderAccept,
+    kHeaderAcceptEncoding,
+    kHeaderAcceptLanguage,
+    kHeaderUserAgent,
+    kHeaderOrigin,
+    kHeaderReferer,
+    kHeaderCacheControl,
+    kHeaderIfNoneMatch,
+    kHeaderIfModifiedSince,
+    kHeaderExpect,
+    kHeaderUpgrade,
+    kHeaderRange,
+    kHeaderXForwardedFor,
+    kHeaderXRealIp,
+    kHeaderPragma,
+    kHeaderSecWebSocketKey,
+    kHeaderAccessControlRequestMethod,
+    kHeaderAccessControlRequestHeaders,
+    kNumKnownHeaders, // 不是常用头部
+};
+
+namespace headers
+{
+
+// 规范写法，按 KnownHeader 索引
+constexpr std::string_view kNames[kNumKnownHeaders] = {
+    "Host", "Connection", "Content-Length", "Content-Type", "Transfer-Encoding",
+    "Cookie", "Authorization", "Accept", "Accept-Encoding", "Accept-Language",
+    "User-Agent", "Origin", "Referer", "Cache-Control", "If-None-Match",
+    "If-Modified-Since", "Expect", "Upgrade", "Range", "X-Forwarded-For",
+    "X-Real-IP", "Pragma", "Sec-WebSocket-Key", "Access-Control-Request-Method",
+    "Access-Control-Request-Headers",
+};
+
+constexpr size_t kTableSize = 64;
+
+// 对上面这组名字无冲突的哈希：长度、首字符、末字符、中间字符，字母按小写计算。
+// 增删头部后如果出现冲突，下面的 static_assert 会编译失败，调整系数即可
+constexpr size_t hash(std::string_view name)
+{
+    size_t n = name.size();
+    return (n + (name[0] | 0x20) * 10 + (name[n - 1] | 0x20) * 20 + (name[n / 2] | 0x20)) & (kTableSize - 1);
+}
+
+struct SlotTable
+{
+    uint8_t slots[kTableSize]; // 哈希值 -> KnownHeader，空槽为 kNumKnownHeaders
+    bool    perfect;
+};
+
+constexpr SlotTable buildTable()
+{
+    SlotTable table{};
+    table.perfect = true;
+    for (size_t i = 0; i < kTableSize; ++i)
+    {
+        table.slots[i] = kNumKnownHeaders;
+    }
+    for (size_t i = 0; i < kNumKnownHeaders; ++i)
+    {
+        size_t h = hash(kNames[i]);
+        if (table.slots[h] != kNumKnownHeaders)
+        {
+            table.perfect = false;
+        }
+        table.slots[h] = static_cast<uint8_t>(i);
+    }
+    return table;
+}
+
+constexpr SlotTable kTable = buildTable();
+static_assert(kTable.perfect, "known header hash has collisions");
+
+// ASCII 不区分大小写比较
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        char x = a[i], y = b[i];
+        if (x != y)
+        {
+            if ((x | 0x20) != (y | 0x20) || static_cast<unsigned char>((x | 0x20) - 'a') > 'z' - 'a')
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 按名字查找常用头部，不区分大小写；不是常用头部时返回 kNumKnownHeaders。
+// 一次哈希加一次比较，不分配内存
+inline KnownHeader lookup(std::string_view name)
+{
+    if (name.empty())
+    {
+        return kNumKnownHeaders;
+    }
+    uint8_t index = kTable.slots[hash(name)];
+    if (index != kNumKnownHeaders && equalsIgnoreCase(name, kNames[index]))
+    {
+        return static_cast<KnownHeader>(index);
+    }
+    return kNumKnownHeaders;
+}
+
+} // namespace headers
+} // namespace http
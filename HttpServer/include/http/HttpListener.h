@@ -0,0 +1,96 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Callbacks.h>
+#include <muduo/net/Channel.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThreadPool.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpConnection.h>
+
+namespace http
+{
+
+// 监听器：持有一个监听套接字以及它所在的 EventLoop，负责 accept 并创建 TcpConnection
+// 默认模式下只有一个监听器（挂在 mainLoop_ 上），新连接轮询分发给 IO 线程池；
+// 分片模式下每个 IO 线程各自持有一个 SO_REUSEPORT 监听器，连接由内核在各个线程之间均衡，
+// accept 和读写都在同一个线程里完成。
+// 由 shared_ptr 持有：连接的关闭回调只记弱引用，监听器销毁后才关闭的连接不会回调到已释放的对象
+class HttpListener : muduo::noncopyable,
+                     public std::enable_shared_from_this<HttpListener>
+{
+public:
+    // 连接对象创建后、交给 IO 线程之前调用，可以在这里给连接挂上下文（例如记录 socket fd）
+    using NewConnectionCallback = std::function<void (const muduo::net::TcpConnectionPtr&, int sockfd)>;
+
+    HttpListener(muduo::net::EventLoop* loop,
+                 const muduo::net::InetAddress& listenAddr,
+                 const std::string& name,
+                 bool reusePort);
+    // 使用已经绑定并监听的套接字（例如从旧进程交接过来的），监听器接管它的生命期
+    HttpListener(muduo::net::EventLoop* loop,
+                 int listenFd,
+                 const std::string& name);
+    ~HttpListener();
+
+    // 新连接分发到的 IO 线程池；不设置则连接留在监听器自己的 loop 上
+    void setIoLoopPool(muduo::net::EventLoopThreadPool* pool)
+    { ioPool_ = pool; }
+
+    void setConnectionCallback(const muduo::net::ConnectionCallback& cb)
+    { connectionCallback_ = cb; }
+
+    void setMessageCallback(const muduo::net::MessageCallback& cb)
+    { messageCallback_ = cb; }
+
+    void setNewConnectionCallback(const NewConnectionCallback& cb)
+    { newConnectionCallback_ = cb; }
+
+    // 开始监听，必须在 loop_ 所在线程中调用
+    void start();
+
+    // 停止接受新连接并关闭监听套接字，已建立的连接不受影响；必须在 loop_ 所在线程中调用
+    // 监听套接字已经交接给新进程时，关闭的只是本进程的副本
+    void stopAccepting();
+
+    // 停止接受新连接，并把剩下的连接交给各自所在的 IO 线程销毁；必须在 loop_ 所在线程中调用，
+    // 此时这些 IO 线程都还要在运行。析构前必须调用过（没有 start 过的监听器除外）
+    void shutdown();
+
+    int fd() const
+    { return listenFd_; }
+
+    muduo::net::EventLoop* getLoop() const
+    { return loop_; }
+
+    const std::string& name() const
+    { return name_; }
+
+private:
+    void handleRead(muduo::Timestamp receiveTime);
+    void newConnection(int sockfd, const muduo::net::InetAddress& peerAddr);
+    static void removeConnection(const std::weak_ptr<HttpListener>& weakSelf,
+                                 const muduo::net::TcpConnectionPtr& conn);
+    void removeConnectionInLoop(const muduo::net::TcpConnectionPtr& conn);
+
+private:
+    using ConnectionMap = std::map<std::string, muduo::net::TcpConnectionPtr>;
+
+    muduo::net::EventLoop*               loop_; // 监听套接字所在的 loop
+    const std::string                    name_;
+    int                                  listenFd_; // 监听套接字，stopAccepting 后为 -1
+    int                                  idleFd_; // 预留的空闲 fd，用于应对 EMFILE
+    std::unique_ptr<muduo::net::Channel> acceptChannel_;
+    muduo::net::EventLoopThreadPool*     ioPool_; // 为空时连接留在 loop_ 上
+    muduo::net::ConnectionCallback       connectionCallback_;
+    muduo::net::MessageCallback          messageCallback_;
+    NewConnectionCallback                newConnectionCallback_;
+    int                                  nextConnId_;
+    ConnectionMap                        connections_; // 只在 loop_ 线程中访问
+};
+
+} // namespace http
@@ -1,14 +1,25 @@
 #pragma once
 
-#include <map>
+#include <stdint.h>
+
+#include <functional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <muduo/base/Timestamp.h>
 
+#include "HttpHeaders.h"
+#include "../utils/TempFile.h"
+
 namespace http
 {
 
+// 请求行、请求头、查询参数和路径参数都拷贝进同一块按请求复用的字节区 arena_，
+// 各字段只记录在其中的偏移和长度，访问器返回指向 arena_ 的 string_view。
+// HttpContext 解析完一个请求后调用 clear() 复用容量，稳定状态下解析一个普通 GET 不需要分配内存。
+// string_view 在请求对象被修改（clear / 追加路径参数）或销毁前有效
 class HttpRequest
 {
 public:
@@ -16,74 +27,187 @@ public:
     {
         kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions
     };
-    
+
     HttpRequest()
         : method_(kInvalid)
-        , version_("Unknown")
+        , version_(&kUnknownVersion)
     {
     }
-    
+
+    // 拷贝一个请求要复制全部头部和请求体，请求对象由 HttpContext 持有并按引用传递，只允许移动
+    HttpRequest(const HttpRequest&) = delete;
+    HttpRequest& operator=(const HttpRequest&) = delete;
+    HttpRequest(HttpRequest&&) = default;
+    HttpRequest& operator=(HttpRequest&&) = default;
+
+    // 显式拷贝出一个独立的请求，用于请求需要比连接上下文活得更久的场合（如缓存的后台刷新）；
+    // 落盘的请求体与原请求共用同一个临时文件
+    HttpRequest clone() const;
+
+    // 清空所有字段但保留已分配的容量，供下一个请求复用
+    void clear();
+
     void setReceiveTime(muduo::Timestamp t);
     muduo::Timestamp receiveTime() const { return receiveTime_; }
-    
+
     bool setMethod(const char* start, const char* end);
     Method method() const { return method_; }
 
     void setPath(const char* start, const char* end);
-    std::string path() const { return path_; }
+    std::string_view path() const { return view(path_); }
+
+    // 一个路由模式最多包含的路径参数（":name" 和 "*name"）个数
+    static const int kMaxPathParameters = 8;
+
+    // 记录路由匹配到的路径参数，不拷贝：name 指向路由表里保存的参数名，value 必须是 path() 中的一段
+    void addPathParameter(std::string_view name, std::string_view value);
+    std::string_view getPathParameters(std::string_view key) const;
 
-    void setPathParameters(const std::string &key, const std::string &value);
-    std::string getPathParameters(const std::string &key) const;
+    int pathParameterCount() const
+    { return numPathParameters_; }
+
+    void clearPathParameters()
+    { numPathParameters_ = 0; }
 
     void setQueryParameters(const char* start, const char* end);
-    std::string getQueryParameters(const std::string &key) const;
-    
-    void setVersion(std::string v)
-    {
-        version_ = v;
-    }
+    std::string_view getQueryParameters(std::string_view key) const;
 
-    std::string getVersion() const
+    // '?' 之后的原始查询串，不带 '?'
+    std::string_view query() const { return view(query_); }
+
+    void setVersion(const std::string& v);
+
+    // 版本只有固定的几种取值，返回静态字符串的引用
+    const std::string& getVersion() const
     {
-        return version_;
+        return *version_;
     }
-    
+
     void addHeader(const char* start, const char* colon, const char* end);
-    std::string getHeader(const std::string& field) const;
 
-    const std::map<std::string, std::string>& headers() const
-    { return headers_; }
+    // 常用头部直接读固定槽位；没有时返回空
+    std::string_view getHeader(KnownHeader header) const
+    { return hasHeader(header) ? view(knownHeaders_[header]) : std::string_view(); }
+
+    bool hasHeader(KnownHeader header) const
+    { return (knownMask_ >> header) & 1; }
+
+    // 常用头部出现了不止一次且取值不同（getHeader 返回的是最后一个）；
+    // 决定请求体边界的头部出现这种情况时必须拒绝，否则可能和上游代理对请求边界的理解不一致
+    bool hasConflictingHeader(KnownHeader header) const
+    { return (conflictMask_ >> header) & 1; }
+
+    // 按名字查找请求头，不区分大小写；常用头部经完美哈希定位到槽位，其余的在少量非常用头部里线性查找
+    std::string_view getHeader(std::string_view field) const;
+
+    // 依次以 (名字, 值) 调用 func：先是常用头部（名字为规范写法），再是其余头部
+    template <typename Func>
+    void forEachHeader(Func&& func) const
+    {
+        for (int i = 0; i < kNumKnownHeaders; ++i)
+        {
+            if (hasHeader(static_cast<KnownHeader>(i)))
+            {
+                func(headers::kNames[i], view(knownHeaders_[i]));
+            }
+        }
+        for (const auto& header : otherHeaders_)
+        {
+            func(view(header.first), view(header.second));
+        }
+    }
 
     void setBody(const std::string& body) { content_ = body; }
-    void setBody(const char* start, const char* end) 
-    { 
-        if (end >= start) 
+    void setBody(const char* start, const char* end)
+    {
+        if (end >= start)
         {
-            content_.assign(start, end - start); 
+            content_.assign(start, end - start);
         }
     }
-    
-    std::string getBody() const
+
+    // 边接收边追加，避免先拼出整个请求体再拷贝一次
+    void appendBody(const char* data, size_t len)
+    { content_.append(data, len); }
+
+    void reserveBody(size_t len)
+    { content_.reserve(len); }
+
+    // 请求体的副本；落盘的请求体会整个读回内存，大请求体应改用 bodyFile()
+    std::string getBody() const;
+
+    // 内存中的请求体，请求体落盘或交给了增量回调时为空
+    const std::string& body() const
     { return content_; }
 
+    // 超过落盘阈值的请求体所在的临时文件，请求对象销毁后删除
+    void setBodyFile(TempFilePtr file)
+    {
+        bodyFile_ = std::move(file);
+        std::string().swap(content_);
+    }
+
+    const TempFilePtr& bodyFile() const
+    { return bodyFile_; }
+
     void setContentLength(uint64_t length)
     { contentLength_ = length; }
-    
+
     uint64_t contentLength() const
     { return contentLength_; }
 
     void swap(HttpRequest& that);
 
+private:
+    // arena_ 中的一段
+    struct Span
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+    using SpanPair = std::pair<Span, Span>;
+
+    // 值记成 arena_ 中的偏移，请求对象被拷贝或交换后仍然有效
+    struct PathParameter
+    {
+        std::string_view name;
+        Span             value;
+    };
+
+    Span store(const char* data, size_t len);
+
+    std::string_view view(Span span) const
+    { return std::string_view(arena_.data() + span.offset, span.length); }
+
+    std::string_view find(const std::vector<SpanPair>& pairs, std::string_view key) const;
+
+    static_assert(kNumKnownHeaders <= 32, "knownMask_ holds one bit per known header");
+
+    static const std::string kHttp10;
+    static const std::string kHttp11;
+    static const std::string kUnknownVersion;
+
 private:
     Method                                       method_; // 请求方法
-    std::string                                  version_; // http版本
-    std::string                                  path_; // 请求路径
-    std::unordered_map<std::string, std::string> pathParameters_; // 路径参数
-    std::unordered_map<std::string, std::string> queryParameters_; // 查询参数
+    const std::string*                           version_; // http版本，指向上面的静态字符串
+    std::string                                  arena_; // 请求行、请求头、参数的字节
+    Span                                         path_; // 请求路径
+    Span                                         query_; // 查询串
+    PathParameter                                pathParameters_[kMaxPathParameters]; // 路径参数
+    int                                          numPathParameters_ { 0 };
+    std::vector<SpanPair>                        queryParameters_; // 查询参数
+    Span                                         knownHeaders_[kNumKnownHeaders]; // 常用头部的值
+    uint32_t                                     knownMask_ { 0 }; // 已出现的常用头部
+    uint32_t                                     conflictMask_ { 0 }; // 重复出现且取值不同的常用头部
+    std::vector<SpanPair>                        otherHeaders_; // 其余头部，数量很少，线性查找
     muduo::Timestamp                             receiveTime_; // 接收时间
-    std::map<std::string, std::string>           headers_; // 请求头
     std::string                                  content_; // 请求体
+    TempFilePtr                                  bodyFile_; // 落盘的请求体，非空时 content_ 为空
     uint64_t                                     contentLength_ { 0 }; // 请求体长度
-};  
+};
+
+// 请求体的增量回调：每收到一段请求体调用一次，返回 false 中止请求（回复 400）。
+// 注册了回调的请求，请求体不再保存在 HttpRequest 里，处理器收到的请求体为空
+using BodyDataCallback = std::function<bool (const HttpRequest&, const char* data, size_t len)>;
 
-} // namespace http
\ No newline at end of file
+} // namespace http
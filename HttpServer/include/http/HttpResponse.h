@@ -2,6 +2,15 @@
 
 #include <muduo/net/TcpServer.h>
 
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ChunkedWriter.h"
+#include "../utils/FileCache.h"
+
 
 namespace http
 {
@@ -22,11 +31,14 @@ public:
         k404NotFound = 404, //服务器不存在资源
         k409Conflict = 409, //请求冲突
         k500InternalServerError = 500, //服务器内部错误
+        k503ServiceUnavailable = 503, //服务器过载，暂时无法处理
     };
 
     HttpResponse(bool close = true)
         : statusCode_(kUnknown)
         , closeConnection_(close)
+        , headerBlock_(nullptr)
+        , wireHeaderBytes_(0)
     {}
 
     void setVersion(std::string version)
@@ -53,30 +65,116 @@ public:
     void setContentLength(uint64_t length)
     { addHeader("Content-Length", std::to_string(length)); }
 
-    void addHeader(const std::string& key, const std::string& value)
-    { headers_[key] = value; }
-    
+    // 同名头部（不区分大小写）会被覆盖；Connection 头部只决定 closeConnection_，序列化时统一输出一次
+    void addHeader(const std::string& key, const std::string& value);
+
+    void removeHeader(const std::string& key);
+
+    // 附加一段预先序列化好的头部（若干行 "Key: Value\r\n"），序列化时整段追加，不逐个拷贝键值；
+    // block 由调用方持有，必须在响应发送完之前一直有效。addHeader / removeHeader / headers() 看不到其中的头部
+    void setHeaderBlock(const std::string* block)
+    { headerBlock_ = block; }
+
+    const std::vector<std::pair<std::string, std::string>>& headers() const
+    { return headers_; }
+
+    const std::string& body() const
+    { return body_; }
+
     void setBody(const std::string& body)
     { 
         body_ = body;
+        file_.reset();
+        stream_ = nullptr;
+        wire_.reset();
         // body_ += "\0";
     }
 
+    // 响应体：普通响应体或预先序列化响应中的响应体部分
+    std::string_view bodyView() const
+    {
+        if (wire_)
+        {
+            return std::string_view(*wire_).substr(wireHeaderBytes_);
+        }
+        return body_;
+    }
+
+    // 文件响应体：只序列化头部，文件内容由 HttpServer 从缓存的 fd 用 sendfile 发送
+    void setFileBody(CachedFilePtr file)
+    {
+        body_.clear();
+        stream_ = nullptr;
+        wire_.reset();
+        setContentLength(file->size());
+        file_ = std::move(file);
+    }
+
+    bool hasFileBody() const
+    { return file_ != nullptr; }
+
+    const CachedFilePtr& fileBody() const
+    { return file_; }
+
+    // 流式响应体：以 Transfer-Encoding: chunked 边生成边发送，不需要事先知道长度。
+    // 处理函数返回后由 HttpServer 在 IO 线程中反复调用 callback，见 ChunkedBodyCallback 和 ChunkedStatus
+    void setChunkedBody(ChunkedBodyCallback callback)
+    {
+        body_.clear();
+        file_.reset();
+        wire_.reset();
+        removeHeader("Content-Length");
+        addHeader("Transfer-Encoding", "chunked");
+        stream_ = std::move(callback);
+    }
+
+    bool hasChunkedBody() const
+    { return static_cast<bool>(stream_); }
+
+    const ChunkedBodyCallback& chunkedBody() const
+    { return stream_; }
+
     void setStatusLine(const std::string& version,
                          HttpStatusCode statusCode,
                          const std::string& statusMessage); //状态行
 
     void setErrorHeader(){}
 
+    // 把状态行、headers_ 和响应体序列化成与连接、请求无关的字节写入 wire，返回其中状态行和头部部分的长度。
+    // Connection、Date 和 headerBlock_ 每次发送时另外生成，不写进 wire
+    size_t serializeForReuse(std::string* wire) const;
+
+    // 使用 serializeForReuse 产生的字节作为整个响应（响应缓存命中时使用）：
+    // 序列化时原样追加 wire 中的状态行和头部，再追加 Connection、Date、headers_ 和 headerBlock_，最后是空行和响应体。
+    // wire 以共享指针持有，不拷贝
+    void setSerialized(std::shared_ptr<const std::string> wire, size_t headerBytes, HttpStatusCode statusCode)
+    {
+        body_.clear();
+        file_.reset();
+        stream_ = nullptr;
+        statusCode_ = statusCode;
+        wire_ = std::move(wire);
+        wireHeaderBytes_ = headerBytes;
+    }
+
+    bool hasSerialized() const
+    { return wire_ != nullptr; }
+
+    // 只序列化状态行和头部（含结尾空行），响应体由调用方决定如何发送
+    void appendHeadersToBuffer(muduo::net::Buffer* outputBuf) const;
     void appendToBuffer(muduo::net::Buffer* outputBuf) const;
 private:
     std::string                        httpVersion_; 
     HttpStatusCode                     statusCode_;
     std::string                        statusMessage_;
     bool                               closeConnection_;
-    std::map<std::string, std::string> headers_;
+    std::vector<std::pair<std::string, std::string>> headers_; // 头部数量很少，线性查找比 map 更快
+    const std::string*                 headerBlock_; // 预先序列化好的头部，不归响应所有
     std::string                        body_;
-    bool                               isFile_;
+    CachedFilePtr                      file_; // 文件响应体，非空时 body_ 不使用
+    ChunkedBodyCallback                stream_; // 流式响应体，非空时 body_ 不使用
+    std::shared_ptr<const std::string> wire_; // 预先序列化的状态行、头部和响应体，非空时状态行和 body_ 不使用
+    size_t                             wireHeaderBytes_; // wire_ 中状态行和头部部分的长度
 };
 
 } // namespace http
\ No newline at end of file
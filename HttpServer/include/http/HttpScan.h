@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace http
+{
+namespace scan
+{
+
+// 请求行和请求头的边界查找，按 CPU 支持情况在启动时选择 AVX2 / SSE2 / 逐字节实现，
+// 一次比较 32 / 16 个字节
+
+// 在 [begin, end) 中查找第一个 c，找不到返回 end（和 std::find 一致）
+const char* findChar(const char* begin, const char* end, char c);
+
+// 在 [begin, end) 中查找第一个 "\r\n"，返回指向 '\r' 的指针，找不到返回 nullptr（和 Buffer::findCRLF 一致）
+const char* findCRLF(const char* begin, const char* end);
+
+// 当前使用的实现："avx2"、"sse2" 或 "scalar"
+const char* implementation();
+
+} // namespace scan
+} // namespace http
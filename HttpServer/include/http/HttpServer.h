@@ -5,26 +5,37 @@
 #include <unistd.h>
 #include "../../../http_cache/include/CacheMiddleware.h"
 #include "../../../http_cache/include/MemoryCacheLRU.h"
+#include "../../../http_cache/include/ShardedCacheLRU.h"
+#include "../../../http_cache/include/TinyLfuCache.h"
 #include "../../../http_cache/include/CachePolicy.h"
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 #include <muduo/net/TcpServer.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThreadPool.h>
 #include <muduo/base/Logging.h>
+#include <muduo/base/ThreadPool.h>
 
 #include "HttpContext.h"
+#include "HttpListener.h"
+#include "TimingWheel.h"
 #include "HttpRequest.h"
 #include "HttpResponse.h"
 #include "../router/Router.h"
 #include "../session/SessionManager.h"
 #include "../middleware/MiddlewareChain.h"
+#include "../middleware/StaticMiddlewareChain.h"
 #include "../middleware/cors/CorsMiddleware.h"
 #include "../ssl/SslConnection.h"
 #include "../ssl/SslContext.h"
+#include "../utils/AccessLog.h"
 
 class HttpRequest;
 class HttpResponse;
@@ -40,6 +51,15 @@ public:
     void enableResponseCache(size_t capacityBytes = 128ull*1024*1024,
                            int ttlSec = 120,
                            int swrSec = 30);
+    // 按完整的缓存策略开启响应缓存，可以选择存储的分片数和淘汰策略
+    void enableResponseCache(const http::cache::CachePolicy& policy);
+
+    // 注册内置的指标路由（Prometheus 文本格式），包括各阶段、各路由的耗时分位数
+    void enableMetrics(const std::string& path = "/metrics");
+
+    // 开启访问日志，需在 start 之前调用；每个线程每 sampleEvery 个请求记录一条，5xx 总是记录
+    void enableAccessLog(const std::string& basename, int sampleEvery = 1,
+                         off_t rollSize = 64 * 1024 * 1024);
     
     // 构造函数
     HttpServer(int port,
@@ -49,14 +69,100 @@ public:
     
     void setThreadNum(int numThreads)
     {
-        server_.setThreadNum(numThreads);
+        numThreads_ = numThreads;
+    }
+
+    // 分片监听模式：每个 IO 线程各自持有一个 SO_REUSEPORT 监听套接字并在本线程 accept，
+    // 由内核在各线程之间均衡新连接，避免突发建连全部排在单个 acceptor 后面
+    void enableShardedListen(bool enable)
+    {
+        shardedListen_ = enable;
+    }
+
+    // 工作线程池大小，为 0 时阻塞型路由也直接在 IO 线程中执行
+    void setWorkerThreadNum(int numThreads)
+    {
+        workerThreadNum_ = numThreads;
+    }
+
+    // 排队和执行中的阻塞型请求上限，超过后直接返回 503
+    void setMaxPendingBlocking(size_t maxPending)
+    {
+        maxPendingBlocking_ = maxPending;
+    }
+
+    // 空闲连接超时（秒），需在 start 之前设置；设为 0 表示不限制该阶段
+    // headerSeconds: 从开始接收请求到请求头收完; bodySeconds: 接收请求体时两次读之间;
+    // keepAliveSeconds: 两个请求之间的空闲，以及等待客户端读走响应
+    void setIdleTimeouts(int headerSeconds, int bodySeconds, int keepAliveSeconds)
+    {
+        headerTimeout_ = headerSeconds;
+        bodyTimeout_ = bodySeconds;
+        keepAliveTimeout_ = keepAliveSeconds;
+    }
+
+    // 单个连接输出缓冲区积压的上限，超过后暂停读取该连接的新请求，排空后恢复；需在 start 之前设置
+    void setOutputHighWaterMark(size_t bytes)
+    {
+        outputHighWaterMark_ = bytes;
+    }
+
+    // 请求体上限（字节），声明或实际收到的请求体超过后回复 413；需在 start 之前设置
+    void setMaxBodySize(size_t bytes)
+    {
+        bodyOptions_.maxBodyBytes = bytes;
+    }
+
+    // 请求体超过 thresholdBytes 后写入 dir 下的临时文件，处理器通过 HttpRequest::bodyFile() 读取；
+    // 需在 start 之前设置
+    void setBodySpill(size_t thresholdBytes, const std::string& dir = "/tmp")
+    {
+        bodyOptions_.spillBytes = thresholdBytes;
+        bodyOptions_.spillDir = dir;
     }
 
+    // 所有连接输出缓冲区里尚未写出的字节数
+    size_t bufferedOutputBytes() const
+    {
+        return bufferedOutputBytes_.load(std::memory_order_relaxed);
+    }
+
+    // 因输出积压而暂停读取的连接数
+    size_t pausedConnections() const
+    {
+        return pausedConnections_.load(std::memory_order_relaxed);
+    }
+
+    // 启动服务，阻塞直到 mainLoop_ 退出（排空完成后）
     void start();
 
+    // 收到 SIGTERM / SIGINT 时排空后退出，需在 start 之前调用；
+    // drainSeconds 是等待处理中请求完成的上限，超时后强制关闭剩余连接
+    void enableGracefulShutdown(double drainSeconds = 30.0)
+    {
+        gracefulShutdown_ = true;
+        drainTimeout_ = drainSeconds;
+    }
+
+    // 不停机重启：启动时先连接 path 向旧进程索取监听套接字，取到后旧进程排空退出；
+    // 之后本进程在 path 上等待下一个新进程。需在 start 之前调用
+    void enableHandoff(const std::string& path)
+    {
+        handoffPath_ = path;
+    }
+
+    // 停止接受新连接，空闲长连接立即关闭，处理中的请求完成后关闭连接，
+    // 超过 timeoutSeconds 后强制关闭；所有连接关闭后 start() 返回。可在任意线程调用
+    void drain(double timeoutSeconds);
+
+    bool draining() const
+    {
+        return draining_.load(std::memory_order_relaxed);
+    }
+
     muduo::net::EventLoop* getLoop() const 
     { 
-        return server_.getLoop(); 
+        return &mainLoop_; 
     }
 
     void setHttpCallback(const HttpCallback& cb)
@@ -76,26 +182,53 @@ public:
         router_.registerHandler(HttpRequest::kGet, path, handler);
     }
 
-    void Post(const std::string& path, const HttpCallback& cb)
+    // onBody 非空时增量接收请求体：请求体每到一段就在 IO 线程中回调一次，不在内存里攒整个请求体；
+    // 请求体收完后照常调用处理器（此时请求体为空）
+    void Post(const std::string& path, const HttpCallback& cb, const BodyDataCallback& onBody = nullptr)
+    {
+        router_.registerCallback(HttpRequest::kPost, path, cb, false, onBody);
+    }
+
+    void Post(const std::string& path, router::Router::HandlerPtr handler, const BodyDataCallback& onBody = nullptr)
+    {
+        router_.registerHandler(HttpRequest::kPost, path, handler, false, onBody);
+    }
+
+    // 注册阻塞型路由处理器（访问数据库、耗时计算等）：在工作线程池中执行，
+    // 完成后把响应投递回连接所属的 IO 线程发送，不占用 IO 线程
+    void GetAsync(const std::string& path, const HttpCallback& cb)
     {
-        router_.registerCallback(HttpRequest::kPost, path, cb);
+        router_.registerCallback(HttpRequest::kGet, path, cb, true);
     }
 
-    void Post(const std::string& path, router::Router::HandlerPtr handler)
+    void GetAsync(const std::string& path, router::Router::HandlerPtr handler)
     {
-        router_.registerHandler(HttpRequest::kPost, path, handler);
+        router_.registerHandler(HttpRequest::kGet, path, handler, true);
     }
 
-    // 注册动态路由处理器
-    void addRoute(HttpRequest::Method method, const std::string& path, router::Router::HandlerPtr handler)
+    void PostAsync(const std::string& path, const HttpCallback& cb, const BodyDataCallback& onBody = nullptr)
     {
-        router_.addRegexHandler(method, path, handler);
+        router_.registerCallback(HttpRequest::kPost, path, cb, true, onBody);
+    }
+
+    void PostAsync(const std::string& path, router::Router::HandlerPtr handler,
+                   const BodyDataCallback& onBody = nullptr)
+    {
+        router_.registerHandler(HttpRequest::kPost, path, handler, true, onBody);
+    }
+
+    // 注册动态路由处理器，path 中可以带 ":name" 参数和结尾的 "*name" 通配；onBody 同 Post
+    void addRoute(HttpRequest::Method method, const std::string& path, router::Router::HandlerPtr handler,
+                  const BodyDataCallback& onBody = nullptr)
+    {
+        router_.registerHandler(method, path, handler, false, onBody);
     }
 
     // 注册动态路由处理函数
-    void addRoute(HttpRequest::Method method, const std::string& path, const router::Router::HandlerCallback& callback)
+    void addRoute(HttpRequest::Method method, const std::string& path, const router::Router::HandlerCallback& callback,
+                  const BodyDataCallback& onBody = nullptr)
     {
-        router_.addRegexCallback(method, path, callback);
+        router_.registerCallback(method, path, callback, false, onBody);
     }
 
     // 设置会话管理器
@@ -116,6 +249,15 @@ public:
         middlewareChain_.addMiddleware(middleware);
     }
 
+    // 添加一组启动时就固定的中间件（按值传入，按顺序执行）：组合成一个 StaticMiddlewareChain，
+    // 每个请求只经过一次虚函数调用，链内各中间件之间是直接调用
+    template <typename... Middlewares>
+    void addMiddlewares(Middlewares... middlewares)
+    {
+        middlewareChain_.addMiddleware(
+            std::make_shared<middleware::StaticMiddlewareChain<Middlewares...>>(std::move(middlewares)...));
+    }
+
     void enableSSL(bool enable) 
     {
         useSSL_ = enable;
@@ -129,15 +271,82 @@ private:
     void onMessage(const muduo::net::TcpConnectionPtr& conn,
                    muduo::net::Buffer* buf,
                    muduo::Timestamp receiveTime);
-    void onRequest(const muduo::net::TcpConnectionPtr&, const HttpRequest&);
+    bool onRequest(const muduo::net::TcpConnectionPtr& conn, HttpContext* context,
+                   const router::Route* route, muduo::net::Buffer* output);
+    bool writeResponse(const muduo::net::TcpConnectionPtr& conn, HttpContext* context,
+                       HttpResponse& response, muduo::net::Buffer* output);
+    void writeWithBody(const muduo::net::TcpConnectionPtr& conn, int sockfd,
+                       muduo::net::Buffer* output, std::string_view body);
+    void onWriteComplete(const muduo::net::TcpConnectionPtr& conn);
+    void onHighWaterMark(const muduo::net::TcpConnectionPtr& conn, size_t len);
+    void pauseReading(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    void updateOutputGauge(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    void sendBody(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    void sendFileBody(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    void sendChunkedBody(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    void queueChunkedResume(const std::weak_ptr<muduo::net::TcpConnection>& weakConn,
+                            muduo::net::EventLoop* loop,
+                            uint64_t generation);
+    void resumeChunkedBody(const std::weak_ptr<muduo::net::TcpConnection>& weakConn, uint64_t generation);
+    void finishBody(const muduo::net::TcpConnectionPtr& conn, HttpContext* context);
+    void resumeParsing(const muduo::net::TcpConnectionPtr& conn);
+    void updateConnectionState(const muduo::net::TcpConnectionPtr& conn, HttpContext* context,
+                         const muduo::net::Buffer* buf);
+    void armIdleTimer(const muduo::net::TcpConnectionPtr& conn, HttpContext* context,
+                      HttpContext::IdlePhase phase);
+
+    // 阻塞型请求：已经过中间件和缓存的请求连同响应对象投递到工作线程池执行路由，队列满时返回 false
+    bool dispatchBlocking(const muduo::net::TcpConnectionPtr& conn, const router::Route* route,
+                          HttpResponse&& response, uint64_t parseNanos);
+    bool onOverloaded(const HttpRequest& req, muduo::net::Buffer* output);
+    void handleBlocking(const muduo::net::TcpConnectionPtr& conn, const HttpContextPtr& context,
+                        const router::Route* route, const std::shared_ptr<HttpResponse>& response,
+                        uint64_t parseNanos);
+    void onBlockingDone(const muduo::net::TcpConnectionPtr& conn,
+                        const std::shared_ptr<muduo::net::Buffer>& output,
+                        const CachedFilePtr& file,
+                        const ChunkedBodyCallback& stream,
+                        bool chunked,
+                        bool close);
 
-    void handleRequest(const HttpRequest& req, HttpResponse* resp);
+    // 设置了 httpCallback_ 时交给它，否则走中间件、缓存和路由；route 为 Router::match 的结果
+    void dispatchRequest(HttpRequest& req, const router::Route* route, HttpResponse* resp);
+    bool handleBeforeRoute(HttpRequest& req, HttpResponse* resp);
+    void handleRoute(HttpRequest& req, const router::Route* route, HttpResponse* resp);
+
+    // 响应缓存的后台刷新：拷贝请求，投递到工作线程池重新执行路由；没有工作线程池时不刷新
+    bool revalidateCached(const HttpRequest& req, const http::cache::CachedEntryPtr& stale);
+    void runRevalidation(const std::shared_ptr<HttpRequest>& req, const http::cache::CachedEntryPtr& stale);
     
+private:
+    // 每个 IO 线程各自的连接状态，只在该线程中访问
+    struct LoopState
+    {
+        std::unique_ptr<TimingWheel>         wheel; // 空闲连接时间轮，未设置超时时为空
+        std::set<muduo::net::TcpConnectionPtr> connections; // 本线程上的全部连接
+    };
+
+    void startListeners(const std::vector<int>& inheritedFds);
+    void startShutdownHandlers();
+    void onShutdownSignalRead();
+    void onHandoffRequest();
+    void drainInLoop(double timeoutSeconds);
+    void closeConnectionsInLoop(muduo::net::EventLoop* loop, bool force);
+    bool isIdle(const muduo::net::TcpConnectionPtr& conn, const HttpContext* context) const;
+    void onDrainDeadline();
+    void checkDrained();
+    void stopThreads();
+
 private:
     muduo::net::InetAddress                      listenAddr_; // 监听地址
-    muduo::net::TcpServer                        server_; 
-    muduo::net::EventLoop                        mainLoop_; // 主循环
-    HttpCallback                                 httpCallback_; // 回调函数
+    std::string                                  name_; // 服务器名
+    mutable muduo::net::EventLoop                mainLoop_; // 主循环
+    bool                                         reusePort_; // 监听套接字是否设置 SO_REUSEPORT
+    bool                                         shardedListen_; // 是否每个 IO 线程各自监听
+    int                                          numThreads_; // IO 线程数
+    std::unique_ptr<muduo::net::EventLoopThreadPool> threadPool_; // IO 线程池
+    std::vector<std::shared_ptr<HttpListener>>   listeners_; // 监听器，分片模式下每个 IO 线程一个
+    HttpCallback                                 httpCallback_; // 自定义的整体处理函数，为空时走中间件和路由
     router::Router                               router_; // 路由
     std::unique_ptr<session::SessionManager>     sessionManager_; // 会话管理器
     middleware::MiddlewareChain                  middlewareChain_; // 中间件链
@@ -145,6 +354,29 @@ private:
     bool                                         useSSL_; // 是否使用 SSL   
     // TcpConnectionPtr -> SslConnectionPtr 
     std::map<muduo::net::TcpConnectionPtr, std::unique_ptr<ssl::SslConnection>> sslConns_;
+    std::unique_ptr<muduo::ThreadPool>            workerPool_; // 阻塞型路由的工作线程池
+    int                                          workerThreadNum_; // 工作线程数
+    size_t                                       maxPendingBlocking_; // 排队 + 执行中的阻塞型请求上限
+    std::atomic<size_t>                          pendingBlocking_; // 当前排队 + 执行中的阻塞型请求数
+    int                                          headerTimeout_; // 接收请求头的超时秒数
+    int                                          bodyTimeout_; // 接收请求体时两次读之间的超时秒数
+    int                                          keepAliveTimeout_; // 长连接空闲超时秒数
+    // 每个 IO 线程一份连接状态，startListeners 之后 map 本身只读
+    std::unordered_map<muduo::net::EventLoop*, std::unique_ptr<LoopState>> loops_;
+    size_t                                       outputHighWaterMark_; // 单个连接输出积压的高水位
+    std::atomic<size_t>                          bufferedOutputBytes_; // 所有连接输出积压之和
+    std::atomic<size_t>                          pausedConnections_; // 因积压暂停读取的连接数
+    std::atomic<bool>                            draining_; // 是否正在排空
+    double                                       drainTimeout_; // 信号或交接触发排空时的超时秒数
+    bool                                         gracefulShutdown_; // 是否处理 SIGTERM / SIGINT
+    std::atomic<int>                             activeConnections_; // 当前连接数
+    std::string                                  handoffPath_; // 监听套接字交接用的 Unix 套接字路径
+    int                                          handoffFd_; // 等待新进程连接的 Unix 监听套接字
+    std::unique_ptr<muduo::net::Channel>         handoffChannel_;
+    int                                          shutdownFd_; // 信号处理函数写入的 eventfd
+    std::unique_ptr<muduo::net::Channel>         shutdownChannel_;
+    std::unique_ptr<AccessLog>                   accessLog_; // 访问日志，未开启时为空
+    BodyOptions                                  bodyOptions_; // 请求体的接收策略，所有连接共享
     std::shared_ptr<http::cache::CacheMiddleware> cache_;
     std::shared_ptr<http::cache::ICacheStore>     cacheStore_;
 }; 
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace http
+{
+
+// 进程间交接监听套接字（零停机重启）：
+// 旧进程在一个 Unix 域套接字上等待，新进程启动时连上来，旧进程用 SCM_RIGHTS 把所有监听 fd 发过去，
+// 之后两个进程共享同一批监听套接字，旧进程停止 accept 并排空，新进程接着 accept，排队中的连接不会丢失
+namespace handoff
+{
+
+// 旧进程：在 path 上创建非阻塞的 Unix 域监听套接字（会先删除残留的同名文件），失败返回 -1
+int listenHandoffSocket(const std::string& path);
+
+// 旧进程：把监听 fd 发给已连接的新进程，成功返回 true
+bool sendListenFds(int sockfd, const std::vector<int>& fds);
+
+// 新进程：连接旧进程的交接套接字并接收监听 fd；旧进程不存在时返回空
+std::vector<int> receiveListenFds(const std::string& path);
+
+} // namespace handoff
+} // namespace http
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Callbacks.h>
+#include <muduo/net/EventLoop.h>
+
+namespace http
+{
+
+// 挂在时间轮上的连接弱引用：时间轮释放最后一个引用（即超时）时关闭连接
+class IdleEntry : muduo::noncopyable
+{
+public:
+    explicit IdleEntry(const muduo::net::TcpConnectionPtr& conn)
+        : conn_(conn)
+        , cancelled_(false)
+        , bucket_(-1)
+    {}
+    ~IdleEntry();
+
+    // 连接换到了另一种超时，旧的条目留在格子里等着被释放，但不再关闭连接
+    void cancel()
+    { cancelled_ = true; }
+
+private:
+    friend class TimingWheel;
+
+    std::weak_ptr<muduo::net::TcpConnection> conn_;
+    bool                                     cancelled_;
+    int                                      bucket_; // 最近一次放入的格子，同一格子重复刷新直接跳过
+};
+
+using IdleEntryPtr = std::shared_ptr<IdleEntry>;
+
+// 空闲连接时间轮（muduo idleconnection 的做法）：每秒转动一格并清空一个格子，
+// 条目的最后一个引用随格子释放时连接超时。每个 IO 线程一个，只在所属 loop 线程中访问，不需要加锁
+class TimingWheel : muduo::noncopyable
+{
+public:
+    // maxTimeout 为支持的最长超时秒数
+    TimingWheel(muduo::net::EventLoop* loop, int maxTimeout);
+
+    // 开始转动，必须在 loop_ 所在线程中调用
+    void start();
+
+    // entry 在 seconds 秒内没有再次 add 就会超时，seconds 不能超过 maxTimeout
+    void add(const IdleEntryPtr& entry, int seconds);
+
+private:
+    void onTick();
+
+private:
+    muduo::net::EventLoop*                 loop_;
+    std::vector<std::vector<IdleEntryPtr>> buckets_;
+    size_t                                 cursor_; // 当前格子，下一次转动时清空它的下一格
+};
+
+} // namespace http
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+namespace http
+{
+namespace metrics
+{
+
+// HDR 风格的对数-线性直方图，记录纳秒级耗时
+// 每个 2 的幂区间再等分成 32 个子桶，相对误差不超过 1/32；小于 64ns 的值精确记录，上限约 137 秒
+// 只允许所属线程写入（无锁、无原子读改写），其它线程可以随时读取做合并
+class Histogram
+{
+public:
+    static const int kSubBucketBits = 5;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+    static const int kMaxBits = 37;
+    static const int kBuckets = (kMaxBits - kSubBucketBits) * kSubBuckets + kSubBuckets;
+
+    Histogram();
+
+    void record(uint64_t nanos)
+    {
+        bump(counts_[bucketIndex(nanos)], 1);
+        bump(count_, 1);
+        bump(sum_, nanos);
+    }
+
+    uint64_t count() const
+    { return count_.load(std::memory_order_relaxed); }
+
+    static int bucketIndex(uint64_t value);
+    // 桶内最大的值，分位数按它输出
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    friend class HistogramSnapshot;
+
+    // 单写者：普通的读 + 写即可，不需要 fetch_add
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta)
+    { counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed); }
+
+    std::atomic<uint64_t> counts_[kBuckets];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+};
+
+// 多个线程的直方图合并后的快照
+class HistogramSnapshot
+{
+public:
+    HistogramSnapshot()
+        : counts_(Histogram::kBuckets, 0)
+        , count_(0)
+        , sum_(0)
+    {}
+
+    void merge(const Histogram& histogram);
+    void merge(const HistogramSnapshot& other);
+
+    // percentile 取 0~100，返回纳秒
+    uint64_t valueAtPercentile(double percentile) const;
+
+    uint64_t count() const
+    { return count_; }
+
+    uint64_t sum() const
+    { return sum_; }
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t              count_;
+    uint64_t              sum_;
+};
+
+} // namespace metrics
+} // namespace http
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <muduo/base/noncopyable.h>
+
+#include "Histogram.h"
+#include "../http/HttpRequest.h"
+
+namespace http
+{
+namespace metrics
+{
+
+// 请求处理的各个阶段
+enum Stage
+{
+    kParse, // HttpContext::parseRequest
+    kMiddlewareBefore, // MiddlewareChain::processBefore
+    kMiddlewareAfter, // MiddlewareChain::processAfter
+    kCacheLookup, // CacheMiddleware::before
+    kHandler, // Router::route 中执行处理器
+    kSerialize, // 响应序列化
+    kStageCount,
+};
+
+inline uint64_t nowNanos()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 当前线程正在处理的请求：累计各阶段耗时，并记下命中的路由，请求结束时一次性写进本线程的直方图
+class RequestTrace
+{
+public:
+    static RequestTrace& current();
+
+    // 解析发生在之前的读事件里，耗时由 HttpContext 累计后传进来
+    void begin(uint64_t parseNanos);
+
+    void add(Stage stage, uint64_t nanos)
+    { nanos_[stage] += nanos; }
+
+    // route 必须在整个进程生命期内有效（由 Router 持有的路由路径或静态字符串）
+    void setRoute(HttpRequest::Method method, const std::string* route)
+    {
+        method_ = method;
+        route_ = route;
+    }
+
+    void finish();
+
+private:
+    uint64_t            nanos_[kStageCount];
+    HttpRequest::Method method_;
+    const std::string*  route_;
+};
+
+// 作用域计时：析构时把经过的时间计入当前请求的某个阶段
+class StageTimer : muduo::noncopyable
+{
+public:
+    explicit StageTimer(Stage stage)
+        : stage_(stage)
+        , start_(nowNanos())
+    {}
+
+    ~StageTimer()
+    { RequestTrace::current().add(stage_, nowNanos() - start_); }
+
+private:
+    Stage    stage_;
+    uint64_t start_;
+};
+
+// 作用域计时：析构时把经过的时间累加到 *total，用于跨多次调用累计的耗时（如分多次读完的请求的解析）
+class ScopedNanos : muduo::noncopyable
+{
+public:
+    explicit ScopedNanos(uint64_t* total)
+        : total_(total)
+        , start_(nowNanos())
+    {}
+
+    ~ScopedNanos()
+    { *total_ += nowNanos() - start_; }
+
+private:
+    uint64_t* total_;
+    uint64_t  start_;
+};
+
+// 所有线程的直方图注册表：记录只写本线程的直方图，不加锁；导出时按需合并
+class Metrics : muduo::noncopyable
+{
+public:
+    static Metrics& getInstance()
+    {
+        static Metrics instance;
+        return instance;
+    }
+
+    // 未命中任何路由、命中缓存时使用的路由标签
+    static const std::string kUnmatchedRoute;
+    static const std::string kCacheHitRoute;
+
+    void record(Stage stage, HttpRequest::Method method, const std::string* route, uint64_t nanos);
+
+    // 合并所有线程的数据，以 Prometheus 文本格式追加到 out
+    void appendPrometheus(std::string* out);
+
+private:
+    struct ThreadMetrics;
+
+    Metrics() = default;
+    ThreadMetrics* threadMetrics();
+
+    std::mutex                                  mutex_;
+    std::vector<std::shared_ptr<ThreadMetrics>> threads_; // 线程退出后数据仍然保留
+};
+
+} // namespace metrics
+} // namespace http
@@ -8,16 +8,23 @@ namespace http
 namespace middleware 
 {
 
+// before 的处理结果
+enum class MiddlewareResult
+{
+    kContinue, // 继续交给后面的中间件、缓存和路由
+    kRespond, // response 已经是完整的回复，跳过后面的中间件、缓存和路由，也不再执行 after
+};
+
 class Middleware 
 {
 public:
     virtual ~Middleware() = default;
     
-    // 请求前处理
-    virtual void before(HttpRequest& request) = 0;
+    // 请求前处理；需要直接回复时（例如 CORS 预检）填好 response 并返回 kRespond，不要抛出异常
+    virtual MiddlewareResult before(HttpRequest& request, HttpResponse& response) = 0;
     
-    // 响应后处理
-    virtual void after(HttpResponse& response) = 0;
+    // 响应后处理，缓存命中的响应也会经过这里
+    virtual void after(const HttpRequest& request, HttpResponse& response) = 0;
     
     // 设置下一个中间件
     void setNext(std::shared_ptr<Middleware> next) 
@@ -13,8 +13,9 @@ class MiddlewareChain
 {
 public:
     void addMiddleware(std::shared_ptr<Middleware> middleware);
-    void processBefore(HttpRequest& request);
-    void processAfter(HttpResponse& response);
+    // 依次执行各中间件的 before，某个中间件要求直接回复时立即返回 kRespond
+    MiddlewareResult processBefore(HttpRequest& request, HttpResponse& response);
+    void processAfter(const HttpRequest& request, HttpResponse& response);
 
 private:
     std::vector<std::shared_ptr<Middleware>> middlewares_;
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <tuple>
+#include <utility>
+
+#include "Middleware.h"
+
+namespace http
+{
+namespace middleware
+{
+
+// 编译期组合的中间件链：中间件按值保存在 tuple 里，before / after 按顺序展开成对具体类型的直接调用，
+// 不经过 shared_ptr 和虚函数表，定义在头文件里的 before / after 还可以被内联。
+// 适合启动时就固定下来的中间件组合；成员类型不需要继承 Middleware，只要提供同样签名的 before / after。
+// 整条链本身也是一个 Middleware，可以作为一个整体加进 MiddlewareChain（见 HttpServer::addMiddlewares）
+template <typename... Middlewares>
+class StaticMiddlewareChain final : public Middleware
+{
+public:
+    explicit StaticMiddlewareChain(Middlewares... middlewares)
+        : middlewares_(std::move(middlewares)...)
+    {}
+
+    MiddlewareResult before(HttpRequest& request, HttpResponse& response) override
+    {
+        return beforeFrom<0>(request, response);
+    }
+
+    // 与 before 相反的顺序执行
+    void after(const HttpRequest& request, HttpResponse& response) override
+    {
+        afterFrom<sizeof...(Middlewares)>(request, response);
+    }
+
+    template <size_t I>
+    auto& get()
+    { return std::get<I>(middlewares_); }
+
+private:
+    template <size_t I>
+    MiddlewareResult beforeFrom(HttpRequest& request, HttpResponse& response)
+    {
+        if constexpr (I == sizeof...(Middlewares))
+        {
+            return MiddlewareResult::kContinue;
+        }
+        else
+        {
+            if (std::get<I>(middlewares_).before(request, response) == MiddlewareResult::kRespond)
+            {
+                return MiddlewareResult::kRespond;
+            }
+            return beforeFrom<I + 1>(request, response);
+        }
+    }
+
+    template <size_t I>
+    void afterFrom(const HttpRequest& request, HttpResponse& response)
+    {
+        if constexpr (I > 0)
+        {
+            std::get<I - 1>(middlewares_).after(request, response);
+            afterFrom<I - 1>(request, response);
+        }
+    }
+
+private:
+    std::tuple<Middlewares...> middlewares_;
+};
+
+} // namespace middleware
+} // namespace http
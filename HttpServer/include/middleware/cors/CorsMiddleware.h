@@ -1,5 +1,10 @@
 #pragma once
 
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 #include "../Middleware.h"
 #include "../../http/HttpRequest.h"
 #include "../../http/HttpResponse.h"
@@ -10,24 +15,42 @@ namespace http
 namespace middleware 
 {
 
-class CorsMiddleware : public Middleware 
+// 所有 Access-Control-* 头部在构造时按来源序列化好，处理请求时只需在哈希表里查一次 Origin，
+// 再把对应的头部块挂到响应上，序列化时整段追加
+class CorsMiddleware final : public Middleware 
 {
 public:
     explicit CorsMiddleware(const CorsConfig& config = CorsConfig::defaultConfig()); //可以显式传入一份 CorsConfig 配置，也可以使用默认配置（允许所有来源 *）
     
-    void before(HttpRequest& request) override;
-    void after(HttpResponse& response) override;
+    // 预检请求（OPTIONS）在这里直接回复
+    MiddlewareResult before(HttpRequest& request, HttpResponse& response) override;
+    void after(const HttpRequest& request, HttpResponse& response) override;
 
     std::string join(const std::vector<std::string>& strings, const std::string& delimiter);
 
 private:
-    bool isOriginAllowed(const std::string& origin) const;
+    // 一个来源对应的两段头部
+    struct OriginHeaders
+    {
+        std::string simple; // 普通响应：Allow-Origin、Allow-Credentials、Vary
+        std::string preflight; // 预检响应：另加 Allow-Methods、Allow-Headers、Max-Age
+    };
+
+    // allowOrigin 为空时不输出 Access-Control-Allow-Origin 行（由调用方按请求回显）
+    OriginHeaders buildHeaders(std::string_view allowOrigin, bool varyOrigin);
+
+    // 请求来源对应的头部；来源不被允许时返回空，reflect 置为 true 表示还要回显请求的 Origin
+    const OriginHeaders* lookup(std::string_view origin, bool* reflect) const;
+
     void handlePreflightRequest(const HttpRequest& request, HttpResponse& response);
-    void addCorsHeaders(HttpResponse& response, const std::string& origin);
 
 private:
-    CorsConfig config_;
+    CorsConfig                                                 config_;
+    std::vector<std::unique_ptr<std::string>>                  origins_; // 允许的来源，originIndex_ 的键指向这里
+    std::unordered_map<std::string_view, OriginHeaders>        originIndex_;
+    std::unique_ptr<OriginHeaders>                             anyOrigin_; // 允许任意来源时使用，否则为空
+    bool                                                       reflectAnyOrigin_; // 任意来源且允许凭据：不能回 "*"，只能回显
 };
 
 } // namespace middleware
-} // namespace http
\ No newline at end of file
+} // namespace http
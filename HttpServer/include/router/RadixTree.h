@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../http/HttpRequest.h"
+
+namespace http
+{
+namespace router
+{
+
+// 一次匹配捕获到的参数值，指向被匹配的路径，不拷贝
+struct PathCaptures
+{
+    std::string_view values[HttpRequest::kMaxPathParameters];
+    int              count = 0;
+};
+
+// 压缩前缀树（radix tree），把路由模式映射到路由编号
+// 模式由三种片段组成：静态文本、":name"（匹配到下一个 '/' 为止的非空片段）、"*name"（匹配剩余全部路径，只能放在最后）
+// 匹配时按 静态 > 参数 > 通配 的优先级逐字节向下走，只有某个分支走不通时才回溯尝试下一种，
+// 常见情况下一次遍历就能确定路由，耗时只和路径长度有关，与注册的路由数量无关
+class RadixTree
+{
+public:
+    RadixTree();
+    ~RadixTree();
+
+    RadixTree(const RadixTree&) = delete;
+    RadixTree& operator=(const RadixTree&) = delete;
+
+    // 插入模式并返回它对应的路由编号：模式已存在时返回已有编号，否则使用 id
+    // 参数名按出现顺序写入 paramNames；模式不合法，或与已有模式形状相同但参数名不同
+    // （例如先注册 /u/:id 再注册 /u/:name）时抛出 std::invalid_argument
+    int insert(std::string_view pattern, int id, std::vector<std::string>* paramNames);
+
+    // 返回匹配的路由编号，没有匹配时返回 -1；captures 为空时不记录参数值
+    int match(std::string_view path, PathCaptures* captures) const;
+
+private:
+    struct Node;
+
+    static Node* insertStatic(Node* node, std::string_view text);
+    static int matchNode(const Node* node, std::string_view path, PathCaptures* captures);
+
+private:
+    std::unique_ptr<Node> root_;
+};
+
+} // namespace router
+} // namespace http
@@ -1,12 +1,11 @@
 #pragma once
-#include <iostream>
-#include <unordered_map>
+#include <deque>
 #include <string>
 #include <memory>
 #include <functional>
-#include <regex>
 #include <vector>
 
+#include "RadixTree.h"
 #include "RouterHandler.h"
 #include "../http/HttpRequest.h"
 #include "../http/HttpResponse.h"
@@ -16,6 +15,18 @@ namespace http
 namespace router
 {
 
+// 一条注册的路由；同一个方法下同一个模式重复注册时是同一条路由，处理器对象优先于回调函数。
+// 形状相同但参数名不同的模式（例如 /users/:id 和 /users/:uid）会匹配同一组路径，注册时抛出 std::invalid_argument
+struct Route
+{
+    std::string pattern; // 注册时的路径模式，用作指标的路由标签
+    std::vector<std::string> paramNames; // 参数名，请求上的路径参数名直接指向这里
+    std::shared_ptr<RouterHandler> handler;
+    std::function<void(const HttpRequest &, HttpResponse *)> callback;
+    BodyDataCallback onBody; // 请求体的增量回调，为空时请求体照常收进 HttpRequest
+    bool blocking = false;
+};
+
 // 选择注册对象式的路由处理器还是注册回调函数式的处理器取决于处理器执行的复杂程度
 // 如果是简单的处理可以注册回调函数，否则注册对象式路由处理器(对象中可封装多个相关函数)
 // 二者注册其一即可
@@ -25,99 +36,39 @@ public:
     using HandlerPtr = std::shared_ptr<RouterHandler>; //复杂对象
     using HandlerCallback = std::function<void(const HttpRequest &, HttpResponse *)>; //回调函数
 
-    // 路由键（请求方法 + URI），方法就是method+path
-    struct RouteKey
-    {
-        HttpRequest::Method method;
-        std::string path;
-
-        bool operator==(const RouteKey &other) const
-        {
-            return method == other.method && path == other.path;
-        }
-    };
-
-    // 为RouteKey 定义哈希函数
-    struct RouteKeyHash
-    {
-        // size_t operator()(const RouteKey& key) const
-        // {
-        //     return std::hash<int>{}(static_cast<int>(key.method)) ^
-        //            std::hash<std::string>{}(key.path);
-        // }
-        size_t operator()(const RouteKey &key) const
-        {
-            size_t methodHash = std::hash<int>{}(static_cast<int>(key.method)); //枚举转换
-            size_t pathHash = std::hash<std::string>{}(key.path);
-            return methodHash * 31 + pathHash;
-        }
-    };
-
     // 注册路由处理器
-    void registerHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler);
+    // path 可以是静态路径，也可以包含 ":name" 参数（匹配一个非空的路径片段）和结尾的 "*name" 通配（匹配剩余路径），
+    // 处理器里用 req.getPathParameters("name") 读取参数值；同一位置上静态片段优先于参数，参数优先于通配
+    // blocking 为 true 表示处理器会阻塞（访问数据库、耗时计算等），HttpServer 会把它放到工作线程池中执行
+    // onBody 非空时请求体每到一段就在 IO 线程中回调一次，不在内存里攒整个请求体，回调里同样可以读路径参数
+    void registerHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler,
+                         bool blocking = false, const BodyDataCallback &onBody = nullptr);
 
-    // 注册回调函数形式的处理器
-    void registerCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback);
+    // 注册回调函数形式的处理器，路径规则同上
+    void registerCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback,
+                          bool blocking = false, const BodyDataCallback &onBody = nullptr);
 
-    // 注册动态路由处理器
-    void addRegexHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler)
-    {
-        std::regex pathRegex = convertToRegex(path);
-        regexHandlers_.emplace_back(method, pathRegex, handler);
-    }
+    // 匹配请求对应的路由，匹配到的路径参数记录在 req 上；没有匹配时返回 nullptr。
+    // 返回的路由在 Router 销毁前有效：调用方可以先据此决定在哪个线程处理，再交给 dispatch，不用再匹配一次
+    const Route *match(HttpRequest &req) const;
 
-    // 注册动态路由处理函数
-    void addRegexCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback)
-    {
-        std::regex pathRegex = convertToRegex(path);
-        regexCallbacks_.emplace_back(method, pathRegex, callback);
-    }
+    // 执行 match 得到的路由的处理器
+    void dispatch(const Route &route, HttpRequest &req, HttpResponse *resp) const;
 
-    // 处理请求
-    bool route(const HttpRequest &req, HttpResponse *resp);
+    // match + dispatch，没有匹配的路由时返回 false
+    bool route(HttpRequest &req, HttpResponse *resp) const;
 
 private:
-    std::regex convertToRegex(const std::string &pathPattern)
-    { // 将路径模式转换为正则表达式，支持匹配任意路径参数
-        std::string regexPattern = "^" + std::regex_replace(pathPattern, std::regex(R"(/:([^/]+))"), R"(/([^/]+))") + "$";
-        return std::regex(regexPattern);
-    }
-
-    // 提取路径参数
-    void extractPathParameters(const std::smatch &match, HttpRequest &request)
-    {
-        // Assuming the first match is the full path, parameters start from index 1
-        for (size_t i = 1; i < match.size(); ++i)
-        {
-            request.setPathParameters("param" + std::to_string(i), match[i].str());
-        }
-    }
+    Route &addRoute(HttpRequest::Method method, const std::string &path);
 
 private:
-    struct RouteCallbackObj
-    {
-        HttpRequest::Method method_;
-        std::regex pathRegex_;
-        HandlerCallback callback_;
-        RouteCallbackObj(HttpRequest::Method method, std::regex pathRegex, const HandlerCallback &callback)
-            : method_(method), pathRegex_(pathRegex), callback_(callback) {}
-    };
-
-    struct RouteHandlerObj
-    {
-        HttpRequest::Method method_;
-        std::regex pathRegex_;
-        HandlerPtr handler_;
-        RouteHandlerObj(HttpRequest::Method method, std::regex pathRegex, HandlerPtr handler)
-            : method_(method), pathRegex_(pathRegex), handler_(handler) {}
-    };
+    // 每个请求方法一棵树，下标是 HttpRequest::Method
+    static const int kNumMethods = HttpRequest::kOptions + 1;
 
-    std::unordered_map<RouteKey, HandlerPtr, RouteKeyHash>      handlers_;       // 精准匹配
-    std::unordered_map<RouteKey, HandlerCallback, RouteKeyHash> callbacks_; // 精准匹配
-    std::vector<RouteHandlerObj>                                regexHandlers_;     // 正则匹配
-    std::vector<RouteCallbackObj>                               regexCallbacks_;   // 正则匹配
+    RadixTree         trees_[kNumMethods];
+    std::deque<Route> routes_; // 下标即路由编号；deque 追加时不移动已有元素，标签和参数名的地址保持不变
 };
 
 
 } // namespace router
-} // namespace http
\ No newline at end of file
+} // namespace http
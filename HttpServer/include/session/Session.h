@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
-#include <chrono>
 
 namespace http
 {
@@ -13,6 +15,7 @@ namespace session
 
 class SessionManager;
 
+// 同一个会话会被 IO 线程和工作线程上的处理函数同时访问，数据和过期时间由 mutex_ 保护
 class Session : public std::enable_shared_from_this<Session>
 {
 public:
@@ -25,10 +28,10 @@ public:
     void refresh(); // 刷新过期时间
 
     void setManager(SessionManager* sessionManager) 
-    { sessionManager_ = sessionManager; }
+    { sessionManager_.store(sessionManager, std::memory_order_relaxed); }
 
     SessionManager* getManager() const 
-    { return sessionManager_; }
+    { return sessionManager_.load(std::memory_order_relaxed); }
 
     // 数据存取
     void setValue(const std::string&key, const std::string&value);
@@ -36,11 +39,12 @@ public:
     void remove(const std::string&key);
     void clear();
 private:
-    std::string                                  sessionId_;
+    const std::string                            sessionId_;
+    mutable std::mutex                           mutex_; // 保护 data_ 和 expiryTime_
     std::unordered_map<std::string, std::string> data_; //map表存储数据
     std::chrono::system_clock::time_point        expiryTime_; //
-    int                                          maxAge_; // 过期时间（秒）
-    SessionManager*                              sessionManager_; 
+    const int                                    maxAge_; // 过期时间（秒）
+    std::atomic<SessionManager*>                 sessionManager_; 
 };
 
 } // namespace session
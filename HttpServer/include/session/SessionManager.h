@@ -4,6 +4,7 @@
 #include "../http/HttpRequest.h"
 #include "../http/HttpResponse.h"
 #include <memory>
+#include <mutex>
 #include <random>
 
 namespace http
@@ -37,7 +38,8 @@ private:
 
 private:
     std::unique_ptr<SessionStorage> storage_;
-    std::mt19937 rng_; // 用于生成随机会话id
+    std::mutex   rngMutex_; // 处理函数可能在多个 IO 线程和工作线程上同时新建会话
+    std::mt19937 rng_; // 用于生成随机会话id，由 rngMutex_ 保护
 };
 
 } // namespace session
@@ -1,6 +1,7 @@
 #pragma once
 #include "Session.h"
 #include <memory>
+#include <mutex>
 
 namespace http
 {
@@ -24,6 +25,8 @@ public:
     std::shared_ptr<Session> load(const std::string& sessionId) override;
     void remove(const std::string& sessionId) override;
 private:
+    // 阻塞型路由在工作线程中执行，会话存储会被多个线程同时访问
+    std::mutex                                                mutex_;
     std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
 };
 
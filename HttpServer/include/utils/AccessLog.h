@@ -0,0 +1,74 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <muduo/base/AsyncLogging.h>
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/TcpConnection.h>
+
+#include "../http/HttpRequest.h"
+
+namespace http
+{
+
+// 一条访问日志，定长，写入时不分配内存，格式化放到后台线程做
+struct AccessLogRecord
+{
+    int64_t             receiveTimeUs; // 请求接收时间
+    uint32_t            latencyUs; // 从接收到响应生成的耗时
+    uint32_t            bytes; // 响应体字节数
+    uint16_t            status;
+    uint8_t             method; // HttpRequest::Method
+    uint8_t             pathLen; // 超长路径会被截断
+    struct sockaddr_in6 peer;
+    char                path[96];
+};
+
+// 结构化访问日志：每个线程一个无锁单生产者单消费者环形缓冲区，后台线程定期取出、格式化后交给 AsyncLogging 写盘
+// 环形缓冲区满时直接丢弃并计数，请求线程永远不会阻塞在日志上
+class AccessLog : muduo::noncopyable
+{
+public:
+    // sampleEvery 为 N 时每个线程每 N 个请求记录一个，5xx 响应总是记录
+    AccessLog(const std::string& basename, off_t rollSize, int sampleEvery);
+    ~AccessLog();
+
+    void start();
+    void stop();
+
+    void log(const muduo::net::TcpConnectionPtr& conn, const HttpRequest& req,
+             int status, size_t bytes);
+
+    // 因环形缓冲区满而丢弃的记录数
+    uint64_t dropped() const
+    { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Ring;
+
+    Ring* threadRing();
+    void writerThread();
+    void drain();
+
+private:
+    const int                          sampleEvery_;
+    const uint64_t                     instanceId_; // 进程内唯一，线程本地的环形缓冲区按它识别所属实例
+    muduo::AsyncLogging                output_;
+    std::mutex                         mutex_; // 保护 rings_ 和唤醒条件
+    std::condition_variable            cond_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::thread                        writer_;
+    bool                               running_;
+    std::atomic<uint64_t>              dropped_;
+};
+
+} // namespace http
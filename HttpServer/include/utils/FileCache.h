@@ -0,0 +1,67 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/net/Buffer.h>
+
+namespace http
+{
+
+// 打开后常驻的静态文件：fd 一直保持打开，供 sendfile 直接从页缓存发送
+class CachedFile : muduo::noncopyable
+{
+public:
+    CachedFile(int fd, size_t size, time_t mtime)
+        : fd_(fd), size_(size), mtime_(mtime)
+    {}
+    ~CachedFile();
+
+    int fd() const
+    { return fd_; }
+
+    size_t size() const
+    { return size_; }
+
+    time_t mtime() const
+    { return mtime_; }
+
+    // 无法 sendfile 时（如 TLS 连接）把文件内容读进缓冲区
+    bool readInto(muduo::net::Buffer* buf) const;
+
+private:
+    int    fd_;
+    size_t size_;
+    time_t mtime_;
+};
+
+using CachedFilePtr = std::shared_ptr<const CachedFile>;
+
+// 静态文件 fd 缓存：同一路径只打开一次，文件被修改（mtime / 大小变化）后重新打开
+class FileCache : muduo::noncopyable
+{
+public:
+    static FileCache& getInstance()
+    {
+        static FileCache instance;
+        return instance;
+    }
+
+    // 文件不存在或无法打开时返回 nullptr
+    CachedFilePtr open(const std::string& path);
+
+private:
+    FileCache() = default;
+
+    static const size_t kMaxFiles = 1024; // 缓存的 fd 上限，超过后整体清空
+
+    std::mutex                                     mutex_;
+    std::unordered_map<std::string, CachedFilePtr> files_;
+};
+
+} // namespace http
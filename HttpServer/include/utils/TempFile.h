@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <muduo/base/noncopyable.h>
+
+namespace http
+{
+
+// 请求体过大时落盘用的临时文件，对象销毁时删除
+class TempFile : muduo::noncopyable
+{
+public:
+    // 在 dir 下创建临时文件，失败时返回 nullptr
+    static std::shared_ptr<TempFile> create(const std::string& dir);
+
+    ~TempFile();
+
+    bool append(const char* data, size_t len);
+
+    // 把整个文件读进 out，用于兼容只认 std::string 请求体的处理器
+    bool readAll(std::string* out) const;
+
+    int fd() const
+    { return fd_; }
+
+    const std::string& path() const
+    { return path_; }
+
+    size_t size() const
+    { return size_; }
+
+private:
+    TempFile(int fd, const std::string& path)
+        : fd_(fd), path_(path), size_(0)
+    {}
+
+    int         fd_;
+    std::string path_;
+    size_t      size_;
+};
+
+using TempFilePtr = std::shared_ptr<TempFile>;
+
+} // namespace http
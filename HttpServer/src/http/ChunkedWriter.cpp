@@ -0,0 +1,46 @@
+#include "../../include/http/ChunkedWriter.h"
+
+namespace http
+{
+
+void ChunkedWriter::write(const char* data, size_t len)
+{
+    // 长度为 0 的帧表示响应体结束，不能在中途写出
+    if (len == 0)
+    {
+        return;
+    }
+    if (chunked_)
+    {
+        static const char kHexDigits[] = "0123456789abcdef";
+        char header[sizeof(size_t) * 2 + 2];
+        char* end = header + sizeof header;
+        char* p = end;
+        *--p = '\n';
+        *--p = '\r';
+        size_t n = len;
+        do
+        {
+            *--p = kHexDigits[n & 0xf];
+            n >>= 4;
+        } while (n > 0);
+        output_->append(p, end - p);
+        output_->append(data, len);
+        output_->append("\r\n", 2);
+    }
+    else
+    {
+        output_->append(data, len);
+    }
+    bytesWritten_ += len;
+}
+
+void ChunkedWriter::finish()
+{
+    if (chunked_)
+    {
+        output_->append("0\r\n\r\n", 5);
+    }
+}
+
+} // namespace http
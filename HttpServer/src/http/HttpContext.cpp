@@ -1,11 +1,33 @@
 #include "../../include/http/HttpContext.h"
 
+#include "../../include/http/HttpScan.h"
+#include "../../include/metrics/Metrics.h"
+#include "../../include/router/Router.h"
+
 using namespace muduo;
 using namespace muduo::net;
 
 namespace http
 {
 
+namespace
+{
+
+const BodyOptions kDefaultBodyOptions;
+
+// 块大小行（含块扩展）和 trailer 行的长度上限，防止没有换行的数据一直堆在缓冲区里
+const size_t kMaxChunkLine = 4096;
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
 // 将报文解析出来将关键信息封装到HttpRequest对象里面去
 /*
 "GET /search?q=cpp HTTP/1.1\r\n"
@@ -15,13 +37,14 @@ namespace http
 */
 bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
 {
+    metrics::ScopedNanos timer(&parseNanos_); // 一个请求可能分多次读完，解析耗时累计到请求结束
     bool ok = true; // 解析每行请求格式是否正确
     bool hasMore = true;
     while (hasMore)
     {
         if (state_ == kExpectRequestLine) //正常初始状态
         {
-            const char *crlf = buf->findCRLF(); // 注意这个返回值边界可能有错,findCRLF() 查找 \r\n，表示一行结束。
+            const char *crlf = findLineEnd(buf); // 查找 \r\n，表示一行结束；上次没找到时从上次扫到的位置继续
             if (crlf)
             {
                 ok = processRequestLine(buf->peek(), crlf); //buf->peek()：返回缓冲区当前可读数据的起始指针, crlf：是结束指针，processRequestLine函数
@@ -43,10 +66,10 @@ bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
         }
         else if (state_ == kExpectHeaders)
         {
-            const char *crlf = buf->findCRLF();
+            const char *crlf = findLineEnd(buf);
             if (crlf)
             {
-                const char *colon = std::find(buf->peek(), crlf, ':'); //buf->peek是muduo库里包装的函数，代表可读区间起始地址
+                const char *colon = scan::findChar(buf->peek(), crlf, ':'); //buf->peek是muduo库里包装的函数，代表可读区间起始地址
                 if (colon < crlf)
                 {
                     request_.addHeader(buf->peek(), colon, crlf); //addHeader函数
@@ -54,41 +77,13 @@ bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
                 else if (buf->peek() == crlf)
                 { 
                     // 空行，结束Header
-                    // 根据请求方法和Content-Length判断是否需要继续读取body
-                    if (request_.method() == HttpRequest::kPost || 
-                        request_.method() == HttpRequest::kPut)
-                    {
-                        std::string contentLength = request_.getHeader("Content-Length");
-                        if (!contentLength.empty())
-                        {
-                            request_.setContentLength(std::stoi(contentLength));
-                            if (request_.contentLength() > 0)
-                            {
-                                state_ = kExpectBody;
-                            }
-                            else
-                            {
-                                state_ = kGotAll;
-                                hasMore = false;
-                            }
-                        }
-                        else
-                        {
-                            // POST/PUT 请求没有 Content-Length，是HTTP语法错误
-                            ok = false;
-                            hasMore = false;
-                        }
-                    }
-                    else
-                    {
-                        // GET/HEAD/DELETE 等方法直接完成（没有请求体）
-                        state_ = kGotAll; 
-                        hasMore = false;
-                    }
+                    // 根据 Transfer-Encoding 和 Content-Length 判断是否需要继续读取body
+                    ok = startBody();
+                    hasMore = ok && state_ == kExpectBody;
                 }
                 else
                 {
-                    ok = false; // Header行格式错误
+                    ok = fail(400); // Header行格式错误
                     hasMore = false;
                 }
                 buf->retrieveUntil(crlf + 2); // 开始读指针指向下一行数据
@@ -100,25 +95,259 @@ bool HttpContext::parseRequest(Buffer *buf, Timestamp receiveTime)
         }
         else if (state_ == kExpectBody)
         {
-            // 检查缓冲区中是否有足够的数据
-            if (buf->readableBytes() < request_.contentLength())
+            // 请求体边到边处理，不等整个请求体收齐
+            ok = bodyChunked_ ? parseChunkedBody(buf) : parseFixedBody(buf);
+            hasMore = false;
+        }
+        else
+        {
+            hasMore = false;
+        }
+    }
+    if (!ok && errorStatus_ == 0)
+    {
+        errorStatus_ = 400;
+    }
+    return ok; // ok为false代表报文语法解析错误
+}
+
+// 一行没收完时记住已经扫过的长度，下次读到数据只扫新到的部分，
+// 慢速客户端分很多次发一个长请求头时不会反复从头扫描
+const char* HttpContext::findLineEnd(const Buffer* buf)
+{
+    const char* begin = buf->peek();
+    const char* end = begin + buf->readableBytes();
+    // 上次末尾可能停在 '\r' 上，退一个字节，让它和新到的 '\n' 配对
+    size_t offset = scanOffset_ > 0 ? scanOffset_ - 1 : 0;
+    const char* crlf = scan::findCRLF(begin + offset, end);
+    scanOffset_ = crlf ? 0 : buf->readableBytes();
+    return crlf;
+}
+
+const BodyOptions& HttpContext::bodyOptions() const
+{
+    return bodyOptions_ ? *bodyOptions_ : kDefaultBodyOptions;
+}
+
+bool HttpContext::fail(int status)
+{
+    errorStatus_ = status;
+    return false;
+}
+
+// 请求头收完：确定请求体的长度和编码，以及请求体交给谁
+bool HttpContext::startBody()
+{
+    const BodyOptions& options = bodyOptions();
+    // 请求体边界有歧义的请求一律拒绝（回复 400 后关闭连接），避免和上游代理对边界的理解不一致
+    // 而被夹带请求：多个取值不同的 Content-Length 或 Transfer-Encoding，以及二者同时出现（RFC 9112 6.3）
+    if (request_.hasConflictingHeader(kHeaderContentLength)
+        || request_.hasConflictingHeader(kHeaderTransferEncoding))
+    {
+        return fail(400);
+    }
+    const std::string_view transferEncoding = request_.getHeader(kHeaderTransferEncoding);
+    if (!transferEncoding.empty())
+    {
+        // 只支持 chunked
+        if (!headers::equalsIgnoreCase(transferEncoding, "chunked")
+            || request_.hasHeader(kHeaderContentLength))
+        {
+            return fail(400);
+        }
+        bodyChunked_ = true;
+        chunkState_ = kChunkSize;
+    }
+    else
+    {
+        const std::string_view contentLength = request_.getHeader(kHeaderContentLength);
+        if (contentLength.empty())
+        {
+            // 既没有 Content-Length 也没有 Transfer-Encoding：没有请求体
+            state_ = kGotAll;
+            return true;
+        }
+        uint64_t length = 0;
+        for (char c : contentLength)
+        {
+            if (c < '0' || c > '9' || length > options.maxBodyBytes)
             {
-                hasMore = false; // 数据不完整，等待更多数据
-                return true;
+                return fail(c < '0' || c > '9' ? 400 : 413);
+            }
+            length = length * 10 + (c - '0');
+        }
+        // 不等请求体到达，直接按声明的长度拒绝
+        if (length > options.maxBodyBytes)
+        {
+            return fail(413);
+        }
+        request_.setContentLength(length);
+        if (length == 0)
+        {
+            state_ = kGotAll;
+            return true;
+        }
+        bodyRemaining_ = length;
+    }
+
+    if (options.matchRoute)
+    {
+        route_ = options.matchRoute(request_);
+        routeMatched_ = true;
+        if (route_)
+        {
+            bodySink_ = route_->onBody;
+        }
+    }
+    // 长度已知且不会落盘：一次分配到位
+    if (!bodySink_ && !bodyChunked_ && bodyRemaining_ <= options.spillBytes)
+    {
+        request_.reserveBody(bodyRemaining_);
+    }
+    state_ = kExpectBody;
+    return true;
+}
+
+bool HttpContext::parseFixedBody(Buffer* buf)
+{
+    size_t n = std::min(buf->readableBytes(), bodyRemaining_);
+    if (n > 0)
+    {
+        if (!consumeBody(buf->peek(), n))
+        {
+            return false;
+        }
+        buf->retrieve(n);
+        bodyRemaining_ -= n;
+    }
+    if (bodyRemaining_ == 0)
+    {
+        state_ = kGotAll;
+    }
+    return true;
+}
+
+/*
+"1a;ext=1\r\n" 十六进制块大小，分号后是可忽略的块扩展
+"<26 字节数据>\r\n"
+"0\r\n"         最后一个块
+"Trailer: x\r\n" 可选的 trailer，忽略
+"\r\n"
+*/
+bool HttpContext::parseChunkedBody(Buffer* buf)
+{
+    while (state_ == kExpectBody)
+    {
+        if (chunkState_ == kChunkSize || chunkState_ == kChunkTrailer)
+        {
+            const char* crlf = findLineEnd(buf);
+            if (!crlf)
+            {
+                return buf->readableBytes() <= kMaxChunkLine || fail(400);
+            }
+            if (chunkState_ == kChunkTrailer)
+            {
+                bool last = (crlf == buf->peek());
+                buf->retrieveUntil(crlf + 2);
+                if (last)
+                {
+                    request_.setContentLength(bodyReceived_);
+                    state_ = kGotAll;
+                }
+                continue;
             }
 
-            // 只读取 Content-Length 指定的长度
-            std::string body(buf->peek(), buf->peek() + request_.contentLength());
-            request_.setBody(body);
+            size_t size = 0;
+            const char* p = buf->peek();
+            for (; p < crlf && hexValue(*p) >= 0; ++p)
+            {
+                size = size * 16 + hexValue(*p);
+                if (size > bodyOptions().maxBodyBytes)
+                {
+                    return fail(413);
+                }
+            }
+            if (p == buf->peek() || (p < crlf && *p != ';' && *p != ' ' && *p != '\t'))
+            {
+                return fail(400);
+            }
+            buf->retrieveUntil(crlf + 2);
+            if (size == 0)
+            {
+                chunkState_ = kChunkTrailer;
+                continue;
+            }
+            if (bodyReceived_ + size > bodyOptions().maxBodyBytes)
+            {
+                return fail(413);
+            }
+            bodyRemaining_ = size;
+            chunkState_ = kChunkData;
+        }
+        else if (chunkState_ == kChunkData)
+        {
+            size_t n = std::min(buf->readableBytes(), bodyRemaining_);
+            if (n == 0)
+            {
+                return true;
+            }
+            if (!consumeBody(buf->peek(), n))
+            {
+                return false;
+            }
+            buf->retrieve(n);
+            bodyRemaining_ -= n;
+            if (bodyRemaining_ == 0)
+            {
+                chunkState_ = kChunkDataEnd;
+            }
+        }
+        else // kChunkDataEnd
+        {
+            if (buf->readableBytes() < 2)
+            {
+                return true;
+            }
+            if (buf->peek()[0] != '\r' || buf->peek()[1] != '\n')
+            {
+                return fail(400);
+            }
+            buf->retrieve(2);
+            chunkState_ = kChunkSize;
+        }
+    }
+    return true;
+}
 
-            // 准确移动读指针
-            buf->retrieve(request_.contentLength());
+// 一段请求体：交给增量回调，或者追加到内存 / 临时文件里
+bool HttpContext::consumeBody(const char* data, size_t len)
+{
+    bodyReceived_ += len;
+    if (bodySink_)
+    {
+        return bodySink_(request_, data, len) || fail(400);
+    }
 
-            state_ = kGotAll;
-            hasMore = false;
+    const TempFilePtr& file = request_.bodyFile();
+    if (file)
+    {
+        return file->append(data, len) || fail(500);
+    }
+    const BodyOptions& options = bodyOptions();
+    if (request_.body().size() + len > options.spillBytes)
+    {
+        // 超过落盘阈值：已经收到的部分先写进去，之后的数据直接追加到文件
+        TempFilePtr spill = TempFile::create(options.spillDir);
+        if (!spill || !spill->append(request_.body().data(), request_.body().size())
+                   || !spill->append(data, len))
+        {
+            return fail(500);
         }
+        request_.setBodyFile(spill);
+        return true;
     }
-    return ok; // ok为false代表报文语法解析错误
+    request_.appendBody(data, len);
+    return true;
 }
 
 // 解析请求行，方法+查询路径？参数+http版本
@@ -126,11 +355,11 @@ bool HttpContext::processRequestLine(const char *begin, const char *end)
 {
     bool succeed = false;
     const char *start = begin;
-    const char *space = std::find(start, end, ' ');
+    const char *space = scan::findChar(start, end, ' ');
     if (space != end && request_.setMethod(start, space))
     {
         start = space + 1;
-        space = std::find(start, end, ' ');
+        space = scan::findChar(start, end, ' ');
         if (space != end)
         {
             const char *argumentStart = std::find(start, space, '?'); //？左边是查询路径，右边是参数
@@ -0,0 +1,58 @@
+#include "../../include/http/HttpDate.h"
+
+#include <time.h>
+
+namespace http
+{
+
+namespace
+{
+
+struct DateCache
+{
+    char   line[64];
+    size_t len = 0;
+    time_t seconds = 0;
+    bool   ticking = false; // 由所在 loop 的定时器刷新，读取时不再检查时间
+};
+
+thread_local DateCache t_date;
+
+void formatDate(time_t now)
+{
+    struct tm tm;
+    ::gmtime_r(&now, &tm);
+    t_date.len = ::strftime(t_date.line, sizeof t_date.line,
+                            "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+    t_date.seconds = now;
+}
+
+} // namespace
+
+void HttpDate::startTicking(muduo::net::EventLoop* loop)
+{
+    loop->assertInLoopThread();
+    t_date.ticking = true;
+    refresh();
+    loop->runEvery(1.0, &HttpDate::refresh);
+}
+
+muduo::StringPiece HttpDate::headerLine()
+{
+    if (!t_date.ticking)
+    {
+        time_t now = ::time(nullptr);
+        if (now != t_date.seconds)
+        {
+            formatDate(now);
+        }
+    }
+    return muduo::StringPiece(t_date.line, static_cast<int>(t_date.len));
+}
+
+void HttpDate::refresh()
+{
+    formatDate(::time(nullptr));
+}
+
+} // namespace http
@@ -0,0 +1,220 @@
+#include "../../include/http/HttpListener.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+namespace
+{
+
+int createListenSocket(const muduo::net::InetAddress& addr, bool reusePort)
+{
+    int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0)
+    {
+        LOG_SYSFATAL << "HttpListener: socket failed";
+    }
+
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+    if (reusePort && ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof on) < 0)
+    {
+        LOG_SYSERR << "HttpListener: SO_REUSEPORT failed";
+    }
+
+    if (::bind(fd, addr.getSockAddr(), static_cast<socklen_t>(sizeof(struct sockaddr_in6))) < 0)
+    {
+        LOG_SYSFATAL << "HttpListener: bind " << addr.toIpPort() << " failed";
+    }
+    return fd;
+}
+
+} // namespace
+
+HttpListener::HttpListener(muduo::net::EventLoop* loop,
+                           const muduo::net::InetAddress& listenAddr,
+                           const std::string& name,
+                           bool reusePort)
+    : loop_(loop)
+    , name_(name)
+    , listenFd_(createListenSocket(listenAddr, reusePort))
+    , idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    , acceptChannel_(new muduo::net::Channel(loop, listenFd_))
+    , ioPool_(nullptr)
+    , nextConnId_(1)
+{
+    acceptChannel_->setReadCallback(
+        std::bind(&HttpListener::handleRead, this, std::placeholders::_1));
+}
+
+HttpListener::HttpListener(muduo::net::EventLoop* loop,
+                           int listenFd,
+                           const std::string& name)
+    : loop_(loop)
+    , name_(name)
+    , listenFd_(listenFd)
+    , idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    , acceptChannel_(new muduo::net::Channel(loop, listenFd_))
+    , ioPool_(nullptr)
+    , nextConnId_(1)
+{
+    // 交接过来的套接字可能没有设置非阻塞
+    int flags = ::fcntl(listenFd_, F_GETFL, 0);
+    ::fcntl(listenFd_, F_SETFL, flags | O_NONBLOCK);
+    ::fcntl(listenFd_, F_SETFD, FD_CLOEXEC);
+    acceptChannel_->setReadCallback(
+        std::bind(&HttpListener::handleRead, this, std::placeholders::_1));
+}
+
+// 可能在任意线程析构（最后一个引用可能在连接的关闭回调里释放），只释放不属于任何 loop 的资源；
+// 监听通道和连接已经由 shutdown 在 loop_ 线程中清理
+HttpListener::~HttpListener()
+{
+    if (listenFd_ >= 0)
+    {
+        // 没有 start 过，通道从未加入 loop
+        ::close(listenFd_);
+    }
+    ::close(idleFd_);
+}
+
+void HttpListener::start()
+{
+    loop_->assertInLoopThread();
+    if (::listen(listenFd_, SOMAXCONN) < 0)
+    {
+        LOG_SYSFATAL << "HttpListener[" << name_ << "] listen failed";
+    }
+    acceptChannel_->enableReading();
+}
+
+void HttpListener::stopAccepting()
+{
+    loop_->assertInLoopThread();
+    if (listenFd_ < 0)
+    {
+        return;
+    }
+    acceptChannel_->disableAll();
+    acceptChannel_->remove();
+    ::close(listenFd_);
+    listenFd_ = -1;
+    LOG_INFO << "HttpListener[" << name_ << "] stopped accepting";
+}
+
+void HttpListener::shutdown()
+{
+    loop_->assertInLoopThread();
+    stopAccepting();
+    // 先整体换出来：同一线程上的连接会在 runInLoop 里立即销毁
+    ConnectionMap connections;
+    connections.swap(connections_);
+    for (auto& item : connections)
+    {
+        muduo::net::TcpConnectionPtr conn(item.second);
+        item.second.reset();
+        conn->getLoop()->runInLoop(
+            std::bind(&muduo::net::TcpConnection::connectDestroyed, conn));
+    }
+}
+
+void HttpListener::handleRead(muduo::Timestamp)
+{
+    loop_->assertInLoopThread();
+    // 一次把积压的连接全部取完，避免突发建连时每个连接都要等一轮 epoll
+    while (true)
+    {
+        struct sockaddr_in6 addr;
+        socklen_t addrlen = static_cast<socklen_t>(sizeof addr);
+        int connfd = ::accept4(listenFd_, reinterpret_cast<struct sockaddr*>(&addr),
+                               &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (connfd >= 0)
+        {
+            newConnection(connfd, muduo::net::InetAddress(addr));
+            continue;
+        }
+
+        int savedErrno = errno;
+        if (savedErrno == EINTR)
+        {
+            continue;
+        }
+        if (savedErrno == EMFILE)
+        {
+            // fd 耗尽：借用预留的 fd 把连接接下来再立即关闭，否则监听套接字会一直可读
+            ::close(idleFd_);
+            idleFd_ = ::accept(listenFd_, nullptr, nullptr);
+            ::close(idleFd_);
+            idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        }
+        else if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
+        {
+            LOG_SYSERR << "HttpListener[" << name_ << "] accept failed";
+        }
+        break;
+    }
+}
+
+void HttpListener::newConnection(int sockfd, const muduo::net::InetAddress& peerAddr)
+{
+    muduo::net::EventLoop* ioLoop = ioPool_ ? ioPool_->getNextLoop() : loop_;
+
+    struct sockaddr_in6 local;
+    socklen_t addrlen = static_cast<socklen_t>(sizeof local);
+    ::memset(&local, 0, sizeof local);
+    if (::getsockname(sockfd, reinterpret_cast<struct sockaddr*>(&local), &addrlen) < 0)
+    {
+        LOG_SYSERR << "HttpListener: getsockname failed";
+    }
+
+    std::string connName = name_ + "-" + peerAddr.toIpPort() + "#" + std::to_string(nextConnId_++);
+    auto conn = std::make_shared<muduo::net::TcpConnection>(
+        ioLoop, connName, sockfd, muduo::net::InetAddress(local), peerAddr);
+    connections_[connName] = conn;
+    conn->setConnectionCallback(connectionCallback_);
+    conn->setMessageCallback(messageCallback_);
+    conn->setCloseCallback(
+        std::bind(&HttpListener::removeConnection, std::weak_ptr<HttpListener>(shared_from_this()),
+                  std::placeholders::_1));
+    if (newConnectionCallback_)
+    {
+        newConnectionCallback_(conn, sockfd);
+    }
+    ioLoop->runInLoop(std::bind(&muduo::net::TcpConnection::connectEstablished, conn));
+}
+
+// 在连接所在的 IO 线程中调用
+void HttpListener::removeConnection(const std::weak_ptr<HttpListener>& weakSelf,
+                                    const muduo::net::TcpConnectionPtr& conn)
+{
+    std::shared_ptr<HttpListener> self = weakSelf.lock();
+    if (!self)
+    {
+        conn->getLoop()->queueInLoop(
+            std::bind(&muduo::net::TcpConnection::connectDestroyed, conn));
+        return;
+    }
+    self->loop_->runInLoop(std::bind(&HttpListener::removeConnectionInLoop, self, conn));
+}
+
+void HttpListener::removeConnectionInLoop(const muduo::net::TcpConnectionPtr& conn)
+{
+    loop_->assertInLoopThread();
+    // 已经被 shutdown 接手销毁的连接不能再销毁一次
+    if (connections_.erase(conn->name()) == 0)
+    {
+        return;
+    }
+    conn->getLoop()->queueInLoop(
+        std::bind(&muduo::net::TcpConnection::connectDestroyed, conn));
+}
+
+} // namespace http
@@ -1,8 +1,50 @@
 #include "../../include/http/HttpRequest.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 namespace http
 {
 
+const std::string HttpRequest::kHttp10 = "HTTP/1.0";
+const std::string HttpRequest::kHttp11 = "HTTP/1.1";
+const std::string HttpRequest::kUnknownVersion = "Unknown";
+
+namespace
+{
+
+// clear() 时超过这个容量的缓冲区直接释放，避免一个大请求之后连接一直占着内存
+const size_t kMaxRetainedBytes = 64 * 1024;
+
+} // namespace
+
+void HttpRequest::clear()
+{
+    method_ = kInvalid;
+    version_ = &kUnknownVersion;
+    if (arena_.capacity() > kMaxRetainedBytes)
+    {
+        std::string().swap(arena_);
+    }
+    arena_.clear();
+    path_ = Span();
+    query_ = Span();
+    numPathParameters_ = 0;
+    queryParameters_.clear();
+    knownMask_ = 0;
+    conflictMask_ = 0;
+    otherHeaders_.clear();
+    receiveTime_ = muduo::Timestamp();
+    if (content_.capacity() > kMaxRetainedBytes)
+    {
+        std::string().swap(content_);
+    }
+    content_.clear();
+    bodyFile_.reset();
+    contentLength_ = 0;
+}
+
 void HttpRequest::setReceiveTime(muduo::Timestamp t)
 {
     receiveTime_ = t;
@@ -11,7 +53,7 @@ void HttpRequest::setReceiveTime(muduo::Timestamp t)
 bool HttpRequest::setMethod(const char *start, const char *end)
 {
     assert(method_ == kInvalid);
-    std::string m(start, end); // [start, end)
+    std::string_view m(start, end - start); // [start, end)
     if (m == "GET")
     {
         method_ = kGet;
@@ -42,104 +84,201 @@ bool HttpRequest::setMethod(const char *start, const char *end)
 
 void HttpRequest::setPath(const char *start, const char *end)
 {
-    path_.assign(start, end);
+    path_ = store(start, end - start);
 }
 
-void HttpRequest::setPathParameters(const std::string &key, const std::string &value)
+void HttpRequest::addPathParameter(std::string_view name, std::string_view value)
 {
-    pathParameters_[key] = value;
+    assert(numPathParameters_ < kMaxPathParameters);
+    assert(value.data() >= arena_.data() && value.data() + value.size() <= arena_.data() + arena_.size());
+    PathParameter& param = pathParameters_[numPathParameters_++];
+    param.name = name;
+    param.value = Span{static_cast<uint32_t>(value.data() - arena_.data()), static_cast<uint32_t>(value.size())};
 }
 
-std::string HttpRequest::getPathParameters(const std::string &key) const
+std::string_view HttpRequest::getPathParameters(std::string_view key) const
 {
-    auto it = pathParameters_.find(key);
-    if (it != pathParameters_.end())
+    for (int i = 0; i < numPathParameters_; ++i)
     {
-        return it->second;
+        if (pathParameters_[i].name == key)
+        {
+            return view(pathParameters_[i].value);
+        }
     }
-    return "";
+    return std::string_view();
 }
 
-std::string HttpRequest::getQueryParameters(const std::string &key) const
+std::string_view HttpRequest::getQueryParameters(std::string_view key) const
 {
-    auto it = queryParameters_.find(key);
-    if (it != queryParameters_.end())
-    {
-        return it->second;
-    }
-    return "";
+    return find(queryParameters_, key);
 }
 
-// 这是从问号后面分割参数
+// 这是从问号后面分割参数，键值都指向 arena_ 中的查询串，不再单独拷贝
 void HttpRequest::setQueryParameters(const char *start, const char *end)
 {
-    std::string argumentStr(start, end);
-    std::string::size_type pos = 0;
-    std::string::size_type prev = 0;
+    query_ = store(start, end - start);
+    uint32_t pos = query_.offset;
+    uint32_t stop = query_.offset + query_.length;
 
     // 按 & 分割多个参数
-    while ((pos = argumentStr.find('&', prev)) != std::string::npos)
+    while (pos <= stop)
     {
-        std::string pair = argumentStr.substr(prev, pos - prev);
-        std::string::size_type equalPos = pair.find('=');
-
-        if (equalPos != std::string::npos)
+        const char *base = arena_.data();
+        const char *amp = static_cast<const char *>(::memchr(base + pos, '&', stop - pos));
+        uint32_t pairEnd = amp ? static_cast<uint32_t>(amp - base) : stop;
+        const char *equal = static_cast<const char *>(::memchr(base + pos, '=', pairEnd - pos));
+        if (equal)
         {
-            std::string key = pair.substr(0, equalPos);
-            std::string value = pair.substr(equalPos + 1);
-            queryParameters_[key] = value;
+            uint32_t equalPos = static_cast<uint32_t>(equal - base);
+            queryParameters_.emplace_back(Span{pos, equalPos - pos},
+                                          Span{equalPos + 1, pairEnd - equalPos - 1});
         }
-
-        prev = pos + 1;
+        pos = pairEnd + 1;
     }
+}
 
-    // 处理最后一个参数
-    std::string lastPair = argumentStr.substr(prev);
-    std::string::size_type equalPos = lastPair.find('=');
-    if (equalPos != std::string::npos)
+void HttpRequest::setVersion(const std::string &v)
+{
+    if (v == kHttp11)
     {
-        std::string key = lastPair.substr(0, equalPos);
-        std::string value = lastPair.substr(equalPos + 1);
-        queryParameters_[key] = value;
+        version_ = &kHttp11;
+    }
+    else if (v == kHttp10)
+    {
+        version_ = &kHttp10;
+    }
+    else
+    {
+        version_ = &kUnknownVersion;
     }
 }
 
 void HttpRequest::addHeader(const char *start, const char *colon, const char *end)
 {
-    std::string key(start, colon); //区间为[)
-    ++colon;
-    while (colon < end && isspace(*colon))
+    const char *valueStart = colon + 1; //区间为[)
+    while (valueStart < end && isspace(*valueStart))
     {
-        ++colon;
+        ++valueStart;
     }
-    std::string value(colon, end);
-    while (!value.empty() && isspace(value[value.size() - 1])) // 消除尾部空格
+    while (end > valueStart && isspace(end[-1])) // 消除尾部空格
     {
-        value.resize(value.size() - 1);
+        --end;
     }
-    headers_[key] = value;
+    Span value = store(valueStart, end - valueStart);
+    // 重复的头部以后出现的为准；常用头部重复且取值不同时记下来，由需要的地方（如请求体边界）拒绝
+    KnownHeader known = headers::lookup(std::string_view(start, colon - start));
+    if (known != kNumKnownHeaders)
+    {
+        if (hasHeader(known) && view(knownHeaders_[known]) != view(value))
+        {
+            conflictMask_ |= 1u << known;
+        }
+        knownHeaders_[known] = value;
+        knownMask_ |= 1u << known;
+        return;
+    }
+    Span key = store(start, colon - start);
+    for (auto &header : otherHeaders_)
+    {
+        if (headers::equalsIgnoreCase(view(header.first), view(key)))
+        {
+            header.second = value;
+            return;
+        }
+    }
+    otherHeaders_.emplace_back(key, value);
+}
+
+std::string_view HttpRequest::getHeader(std::string_view field) const
+{
+    KnownHeader known = headers::lookup(field);
+    if (known != kNumKnownHeaders)
+    {
+        return getHeader(known);
+    }
+    for (const auto &header : otherHeaders_)
+    {
+        if (headers::equalsIgnoreCase(view(header.first), field))
+        {
+            return view(header.second);
+        }
+    }
+    return std::string_view();
+}
+
+HttpRequest::Span HttpRequest::store(const char *data, size_t len)
+{
+    Span span;
+    span.offset = static_cast<uint32_t>(arena_.size());
+    span.length = static_cast<uint32_t>(len);
+    arena_.append(data, len);
+    return span;
+}
+
+std::string_view HttpRequest::find(const std::vector<SpanPair> &pairs, std::string_view key) const
+{
+    for (const auto &pair : pairs)
+    {
+        if (view(pair.first) == key)
+        {
+            return view(pair.second);
+        }
+    }
+    return std::string_view();
 }
 
-std::string HttpRequest::getHeader(const std::string &field) const
+std::string HttpRequest::getBody() const
 {
-    std::string result;
-    auto it = headers_.find(field);
-    if (it != headers_.end())
+    if (bodyFile_)
     {
-        result = it->second;
+        std::string body;
+        bodyFile_->readAll(&body);
+        return body;
     }
-    return result;
+    return content_;
+}
+
+HttpRequest HttpRequest::clone() const
+{
+    // 各字段都是值或 arena_ 中的偏移，逐个复制后在新对象里同样有效
+    HttpRequest copy;
+    copy.method_ = method_;
+    copy.version_ = version_;
+    copy.arena_ = arena_;
+    copy.path_ = path_;
+    copy.query_ = query_;
+    std::copy(pathParameters_, pathParameters_ + numPathParameters_, copy.pathParameters_);
+    copy.numPathParameters_ = numPathParameters_;
+    copy.queryParameters_ = queryParameters_;
+    std::copy(knownHeaders_, knownHeaders_ + kNumKnownHeaders, copy.knownHeaders_);
+    copy.knownMask_ = knownMask_;
+    copy.conflictMask_ = conflictMask_;
+    copy.otherHeaders_ = otherHeaders_;
+    copy.receiveTime_ = receiveTime_;
+    copy.content_ = content_;
+    copy.bodyFile_ = bodyFile_;
+    copy.contentLength_ = contentLength_;
+    return copy;
 }
 
 void HttpRequest::swap(HttpRequest &that)
 {
     std::swap(method_, that.method_);
+    std::swap(arena_, that.arena_);
     std::swap(path_, that.path_);
+    std::swap(query_, that.query_);
     std::swap(pathParameters_, that.pathParameters_);
+    std::swap(numPathParameters_, that.numPathParameters_);
     std::swap(queryParameters_, that.queryParameters_);
     std::swap(version_, that.version_);
-    std::swap(headers_, that.headers_);
+    std::swap(knownHeaders_, that.knownHeaders_);
+    std::swap(knownMask_, that.knownMask_);
+    std::swap(conflictMask_, that.conflictMask_);
+    std::swap(otherHeaders_, that.otherHeaders_);
     std::swap(receiveTime_, that.receiveTime_);
+    std::swap(content_, that.content_);
+    std::swap(bodyFile_, that.bodyFile_);
+    std::swap(contentLength_, that.contentLength_);
 }
 
 } // namespace http
\ No newline at end of file
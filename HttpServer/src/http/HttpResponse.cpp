@@ -1,40 +1,233 @@
 #include "../../include/http/HttpResponse.h"
 
+#include <strings.h>
+
+#include "../../include/http/HttpDate.h"
+
 namespace http
 {
 
-void HttpResponse::appendToBuffer(muduo::net::Buffer* outputBuf) const
+namespace
+{
+
+const int kMaxStatusCode = 600;
+
+// 常用状态码的标准原因短语
+const char* reasonPhrase(int code)
+{
+    switch (code)
+    {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 301: return "Moved Permanently";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 409: return "Conflict";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return nullptr;
+    }
+}
+
+// 预先拼好的 "HTTP/1.x 200 OK\r\n" 状态行，按版本和状态码索引
+struct StatusLineTable
+{
+    std::string lines[2][kMaxStatusCode];
+
+    StatusLineTable()
+    {
+        const char* versions[2] = { "HTTP/1.0", "HTTP/1.1" };
+        for (int v = 0; v < 2; ++v)
+        {
+            for (int code = 0; code < kMaxStatusCode; ++code)
+            {
+                const char* reason = reasonPhrase(code);
+                if (reason)
+                {
+                    lines[v][code] = std::string(versions[v]) + " " + std::to_string(code) + " " + reason + "\r\n";
+                }
+            }
+        }
+    }
+};
+
+const StatusLineTable kStatusLines;
+
+// 版本和原因短语都是标准值时返回预先拼好的状态行，否则返回 nullptr
+const std::string* precomputedStatusLine(const std::string& version, int code, const std::string& message)
+{
+    if (code <= 0 || code >= kMaxStatusCode)
+    {
+        return nullptr;
+    }
+    int v;
+    if (version == "HTTP/1.1")
+    {
+        v = 1;
+    }
+    else if (version == "HTTP/1.0")
+    {
+        v = 0;
+    }
+    else
+    {
+        return nullptr;
+    }
+    const std::string& line = kStatusLines.lines[v][code];
+    if (line.empty())
+    {
+        return nullptr;
+    }
+    // line = 版本(8) + 空格 + 三位状态码 + 空格 + 原因短语 + \r\n
+    if (!message.empty() && line.compare(13, line.size() - 15, message) != 0)
+    {
+        return nullptr;
+    }
+    return &line;
+}
+
+// 非标准状态行：手工拼接，不走 snprintf；Output 为 muduo::net::Buffer 或 std::string
+template <typename Output>
+void appendStatusLine(Output* outputBuf, const std::string& version,
+                      int code, const std::string& message)
+{
+    char digits[4] = { '0', '0', '0', ' ' };
+    for (int i = 2, c = code; i >= 0; --i, c /= 10)
+    {
+        digits[i] = static_cast<char>('0' + c % 10);
+    }
+    outputBuf->append(version);
+    outputBuf->append(" ", 1);
+    outputBuf->append(digits, sizeof digits);
+    outputBuf->append(message);
+    outputBuf->append("\r\n", 2);
+}
+
+const char kConnectionClose[] = "Connection: close\r\n";
+const char kConnectionKeepAlive[] = "Connection: Keep-Alive\r\n";
+
+} // namespace
+
+void HttpResponse::addHeader(const std::string& key, const std::string& value)
+{
+    if (::strcasecmp(key.c_str(), "Connection") == 0)
+    {
+        // 连接头部由 closeConnection_ 统一输出，避免出现两个 Connection
+        closeConnection_ = (::strcasecmp(value.c_str(), "close") == 0);
+        return;
+    }
+    for (auto& header : headers_)
+    {
+        if (::strcasecmp(header.first.c_str(), key.c_str()) == 0)
+        {
+            header.second = value;
+            return;
+        }
+    }
+    headers_.emplace_back(key, value);
+}
+
+void HttpResponse::removeHeader(const std::string& key)
+{
+    for (auto it = headers_.begin(); it != headers_.end(); ++it)
+    {
+        if (::strcasecmp(it->first.c_str(), key.c_str()) == 0)
+        {
+            headers_.erase(it);
+            return;
+        }
+    }
+}
+
+void HttpResponse::appendHeadersToBuffer(muduo::net::Buffer* outputBuf) const
 {
     // HttpResponse封装的信息格式化输出
-    char buf[32]; 
-    // 为什么不把状态信息放入格式化字符串中，因为状态信息有长有短，不方便定义一个固定大小的内存存储
-    snprintf(buf, sizeof buf, "%s %d ", httpVersion_.c_str(), statusCode_);
-    
-    outputBuf->append(buf);
-    outputBuf->append(statusMessage_);
-    outputBuf->append("\r\n");
+    if (wire_)
+    {
+        // 预先序列化的状态行和头部整段追加
+        outputBuf->append(wire_->data(), wireHeaderBytes_);
+    }
+    else
+    {
+        const std::string* statusLine = precomputedStatusLine(httpVersion_, statusCode_, statusMessage_);
+        if (statusLine)
+        {
+            outputBuf->append(*statusLine);
+        }
+        else
+        {
+            appendStatusLine(outputBuf, httpVersion_, statusCode_, statusMessage_);
+        }
+    }
 
-    if (closeConnection_) // 思考一下这些地方是不是可以直接移入近headers_中
+    if (closeConnection_)
     {
-        outputBuf->append("Connection: close\r\n");
+        outputBuf->append(kConnectionClose, sizeof kConnectionClose - 1);
     }
     else
     {
-        //snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", body_.size());
-        //outputBuf->append(buf);
-        outputBuf->append("Connection: Keep-Alive\r\n");
+        outputBuf->append(kConnectionKeepAlive, sizeof kConnectionKeepAlive - 1);
     }
+    outputBuf->append(HttpDate::headerLine());
 
     for (const auto& header : headers_)
     { // 为什么这里不用格式化字符串？因为key和value的长度不定
         outputBuf->append(header.first);
-        outputBuf->append(": "); 
+        outputBuf->append(": ", 2);
         outputBuf->append(header.second);
-        outputBuf->append("\r\n");
+        outputBuf->append("\r\n", 2);
+    }
+    if (headerBlock_)
+    {
+        outputBuf->append(*headerBlock_);
+    }
+    outputBuf->append("\r\n", 2);
+}
+
+void HttpResponse::appendToBuffer(muduo::net::Buffer* outputBuf) const
+{
+    appendHeadersToBuffer(outputBuf);
+    std::string_view body = bodyView();
+    outputBuf->append(body.data(), body.size());
+}
+
+size_t HttpResponse::serializeForReuse(std::string* wire) const
+{
+    if (wire_)
+    {
+        wire->assign(*wire_);
+        return wireHeaderBytes_;
+    }
+    wire->clear();
+    size_t headerBytes = 0;
+    for (const auto& header : headers_)
+    {
+        headerBytes += header.first.size() + header.second.size() + 4;
+    }
+    wire->reserve(httpVersion_.size() + statusMessage_.size() + 8 + headerBytes + bodyView().size());
+
+    const std::string* statusLine = precomputedStatusLine(httpVersion_, statusCode_, statusMessage_);
+    if (statusLine)
+    {
+        wire->append(*statusLine);
+    }
+    else
+    {
+        appendStatusLine(wire, httpVersion_, statusCode_, statusMessage_);
+    }
+    for (const auto& header : headers_)
+    {
+        wire->append(header.first);
+        wire->append(": ", 2);
+        wire->append(header.second);
+        wire->append("\r\n", 2);
     }
-    outputBuf->append("\r\n");
-    
-    outputBuf->append(body_);
+    headerBytes = wire->size();
+    std::string_view body = bodyView();
+    wire->append(body.data(), body.size());
+    return headerBytes;
 }
 
 void HttpResponse::setStatusLine(const std::string& version,
@@ -46,4 +239,4 @@ void HttpResponse::setStatusLine(const std::string& version,
     statusMessage_ = statusMessage;
 }
 
-} // namespace http
\ No newline at end of file
+} // namespace http
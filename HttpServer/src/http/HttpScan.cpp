@@ -0,0 +1,169 @@
+#include "../../include/http/HttpScan.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86 1
+#endif
+
+namespace http
+{
+namespace scan
+{
+
+namespace
+{
+
+const char* findCharScalar(const char* begin, const char* end, char c)
+{
+    const void* p = ::memchr(begin, c, end - begin);
+    return p ? static_cast<const char*>(p) : end;
+}
+
+const char* findCRLFScalar(const char* begin, const char* end)
+{
+    while (begin + 1 < end)
+    {
+        const char* cr = static_cast<const char*>(::memchr(begin, '\r', end - begin - 1));
+        if (!cr)
+        {
+            return nullptr;
+        }
+        if (cr[1] == '\n')
+        {
+            return cr;
+        }
+        begin = cr + 1;
+    }
+    return nullptr;
+}
+
+#ifdef HTTP_SCAN_X86
+
+// SSE2 是 x86-64 的基线指令集，不需要检测；
+// 单字符查找用 pcmpeqb + pmovmskb 比 SSE4.2 的 pcmpestri 更快，所以这里不用 SSE4.2
+__attribute__((target("sse2")))
+const char* findCharSse2(const char* begin, const char* end, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    const char* p = begin;
+    for (; p + 16 <= end; p += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findCharScalar(p, end, c);
+}
+
+// 同时比较 p 处的 '\r' 和 p+1 处的 '\n'，一次判断 16 个位置
+__attribute__((target("sse2")))
+const char* findCRLFSse2(const char* begin, const char* end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char* p = begin;
+    for (; p + 17 <= end; p += 16)
+    {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v0, cr), _mm_cmpeq_epi8(v1, lf)));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findCRLFScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* findCharAvx2(const char* begin, const char* end, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char* p = begin;
+    for (; p + 32 <= end; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findCharSse2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+const char* findCRLFAvx2(const char* begin, const char* end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    for (; p + 33 <= end; p += 32)
+    {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(v0, cr), _mm256_cmpeq_epi8(v1, lf))));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return findCRLFSse2(p, end);
+}
+
+#endif // HTTP_SCAN_X86
+
+using FindCharFunc = const char* (*)(const char*, const char*, char);
+using FindCRLFFunc = const char* (*)(const char*, const char*);
+
+struct ScanImpl
+{
+    FindCharFunc findChar;
+    FindCRLFFunc findCRLF;
+    const char*  name;
+};
+
+// 启动时检测一次 CPU，之后每次调用只是一次间接跳转
+ScanImpl selectImpl()
+{
+#ifdef HTTP_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return { findCharAvx2, findCRLFAvx2, "avx2" };
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return { findCharSse2, findCRLFSse2, "sse2" };
+    }
+#endif
+    return { findCharScalar, findCRLFScalar, "scalar" };
+}
+
+const ScanImpl kImpl = selectImpl();
+
+} // namespace
+
+const char* findChar(const char* begin, const char* end, char c)
+{
+    return kImpl.findChar(begin, end, c);
+}
+
+const char* findCRLF(const char* begin, const char* end)
+{
+    return kImpl.findCRLF(begin, end);
+}
+
+const char* implementation()
+{
+    return kImpl.name;
+}
+
+} // namespace scan
+} // namespace http
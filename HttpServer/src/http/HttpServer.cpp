@@ -1,8 +1,23 @@
 #include "../../include/http/HttpServer.h"
+#include "../../include/http/HttpDate.h"
+#include "../../include/http/ListenerHandoff.h"
+#include "../../include/metrics/Metrics.h"
 
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <algorithm>
 #include <any>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+
+#include <muduo/base/CountDownLatch.h>
 
 namespace http
 {
@@ -15,14 +30,143 @@ void defaultHttpCallback(const HttpRequest &, HttpResponse *resp)
     resp->setCloseConnection(true);
 }
 
+namespace
+{
+
+// 信号处理函数只能做异步信号安全的事：写 eventfd 唤醒主循环，排空在主循环里做
+int g_shutdownEventFd = -1;
+
+void onShutdownSignal(int)
+{
+    uint64_t one = 1;
+    ssize_t n = ::write(g_shutdownEventFd, &one, sizeof one);
+    (void)n;
+}
+
+// 访问日志里记录的响应体大小
+size_t responseBodyBytes(const HttpResponse &resp)
+{
+    return resp.hasFileBody() ? resp.fileBody()->size() : resp.bodyView().size();
+}
+
+// 请求解析失败时的响应，之后连接会被关闭
+void appendParseError(int status, muduo::net::Buffer *output)
+{
+    switch (status)
+    {
+        case 413:
+            output->append("HTTP/1.1 413 Payload Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+            break;
+        case 500:
+            output->append("HTTP/1.1 500 Internal Server Error\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+            break;
+        default:
+            output->append("HTTP/1.1 400 Bad Request\r\n\r\n");
+            break;
+    }
+}
+
+// TLS 连接无法 sendfile，把文件响应体读进 output。读失败（文件被截断等）时撤回本响应从 responseStart
+// 起已经写入的部分，改为回复 500 并关闭连接：头部里的 Content-Length 已经是完整大小，
+// 发出短的响应体会让这个长连接上之后的所有响应错位。返回是否读取成功
+bool appendFileBody(const CachedFile &file, size_t responseStart, muduo::net::Buffer *output)
+{
+    if (file.readInto(output))
+    {
+        return true;
+    }
+    output->unwrite(output->readableBytes() - responseStart);
+    appendParseError(500, output);
+    return false;
+}
+
+HttpContext *connectionContext(const muduo::net::TcpConnectionPtr &conn)
+{
+    return boost::any_cast<HttpContextPtr>(conn->getMutableContext())->get();
+}
+
+// 响应体达到这个大小时不再拷贝进输出缓冲区，改为和头部一起 writev
+const size_t kWritevBodyThreshold = 4096;
+
+// 客户端是否要求处理完本次请求后关闭连接
+bool requestWantsClose(const HttpRequest &req)
+{
+    std::string_view connection = req.getHeader(kHeaderConnection);
+    return ((connection == "close") ||
+            (req.getVersion() == "HTTP/1.0" && connection != "Keep-Alive"));
+}
+
+// 流式响应体：HTTP/1.0 客户端不认识 chunked，去掉该头部，改为用关闭连接标记响应体结束。
+// 返回是否使用 chunked 帧
+bool prepareChunkedBody(const HttpRequest &req, HttpResponse *resp)
+{
+    if (req.getVersion() == "HTTP/1.0")
+    {
+        resp->removeHeader("Transfer-Encoding");
+        resp->setCloseConnection(true);
+        return false;
+    }
+    return true;
+}
+
+// 无法边生成边发送时（TLS 连接）把流式响应体一次生成完写进 output。
+// 这里没有事件循环可以挂起，生产函数返回 kWouldBlock 时就地等它调用 resumer
+void drainChunkedBody(const ChunkedBodyCallback &stream, bool chunked, muduo::net::Buffer *output)
+{
+    struct Latch
+    {
+        std::mutex              mutex;
+        std::condition_variable cond;
+        bool                    ready = false;
+    };
+    auto latch = std::make_shared<Latch>();
+    ChunkedWriter writer(output, chunked);
+    writer.setResumer([latch]
+    {
+        std::lock_guard<std::mutex> lock(latch->mutex);
+        latch->ready = true;
+        latch->cond.notify_one();
+    });
+    ChunkedStatus status;
+    while ((status = stream(&writer)) != ChunkedStatus::kDone)
+    {
+        if (status == ChunkedStatus::kWouldBlock)
+        {
+            std::unique_lock<std::mutex> lock(latch->mutex);
+            latch->cond.wait(lock, [&latch] { return latch->ready; });
+            latch->ready = false;
+        }
+    }
+    writer.finish();
+}
+
+} // namespace
+
 HttpServer::HttpServer(int port,
                        const std::string &name,
                        bool useSSL,
                        muduo::net::TcpServer::Option option)
     : listenAddr_(port)
-    , server_(&mainLoop_, listenAddr_, name, option)
+    , name_(name)
+    , reusePort_(option == muduo::net::TcpServer::kReusePort)
+    , shardedListen_(false)
+    , numThreads_(0)
     , useSSL_(useSSL)
-    , httpCallback_(std::bind(&HttpServer::handleRequest, this, std::placeholders::_1, std::placeholders::_2))
+    , workerThreadNum_(0)
+    , maxPendingBlocking_(1024)
+    , pendingBlocking_(0)
+    , headerTimeout_(10)
+    , bodyTimeout_(30)
+    , keepAliveTimeout_(60)
+    , outputHighWaterMark_(4 * 1024 * 1024)
+    , bufferedOutputBytes_(0)
+    , pausedConnections_(0)
+    , draining_(false)
+    , drainTimeout_(30.0)
+    , gracefulShutdown_(false)
+    , activeConnections_(0)
+    , handoffFd_(-1)
+    , shutdownFd_(-1)
 {
     initialize();
 }
@@ -30,24 +174,317 @@ HttpServer::HttpServer(int port,
 // 服务器运行函数
 void HttpServer::start()
 {
-    LOG_WARN << "HttpServer[" << server_.name() << "] starts listening on" << server_.ipPort();
-    server_.start();
+    if (accessLog_)
+    {
+        accessLog_->start();
+    }
+    LOG_WARN << "HttpServer[" << name_ << "] starts listening on " << listenAddr_.toIpPort()
+             << (shardedListen_ ? " (sharded SO_REUSEPORT)" : "");
+    if (workerThreadNum_ > 0)
+    {
+        workerPool_ = std::make_unique<muduo::ThreadPool>(name_ + "-worker");
+        workerPool_->start(workerThreadNum_);
+    }
+    // 先向旧进程要监听套接字，没有旧进程时自己创建
+    std::vector<int> inheritedFds;
+    if (!handoffPath_.empty())
+    {
+        inheritedFds = handoff::receiveListenFds(handoffPath_);
+    }
+    startListeners(inheritedFds);
+    startShutdownHandlers();
     mainLoop_.loop();
+    stopThreads();
+    LOG_WARN << "HttpServer[" << name_ << "] stopped";
+}
+
+// 主循环退出后按依赖顺序收尾：工作线程和 IO 线程都会用到 loops_、accessLog_、cache_ 等成员，
+// 必须先停掉并 join 它们，再让其余成员按声明逆序析构
+void HttpServer::stopThreads()
+{
+    mainLoop_.assertInLoopThread();
+    if (workerPool_)
+    {
+        // stop 会等正在执行的任务结束，任务里投递到 IO 线程的回调此时 IO 线程还能处理
+        workerPool_->stop();
+        workerPool_.reset();
+    }
+    // 每个监听器在自己的 loop 里停止 accept 并把残留连接交还给各自的 IO 线程销毁，
+    // 所以放在 IO 线程退出之前，并且等它们都做完再释放监听器
+    muduo::CountDownLatch latch(static_cast<int>(listeners_.size()));
+    for (const auto& listener : listeners_)
+    {
+        listener->getLoop()->runInLoop([listener, &latch] {
+            listener->shutdown();
+            latch.countDown();
+        });
+    }
+    latch.wait();
+    listeners_.clear();
+    // 逐个 quit 并 join IO 线程，之后再没有线程访问 loops_
+    threadPool_.reset();
+    loops_.clear();
+
+    if (shutdownChannel_)
+    {
+        // 先恢复默认处理，再关 eventfd，避免信号处理函数写到已关闭（甚至被复用）的描述符
+        ::signal(SIGTERM, SIG_DFL);
+        ::signal(SIGINT, SIG_DFL);
+        g_shutdownEventFd = -1;
+        shutdownChannel_->disableAll();
+        shutdownChannel_->remove();
+        shutdownChannel_.reset();
+    }
+    if (shutdownFd_ >= 0)
+    {
+        ::close(shutdownFd_);
+        shutdownFd_ = -1;
+    }
+    if (handoffChannel_)
+    {
+        // 交接成功时 onHandoffRequest 已经把它从主循环上摘下来了
+        if (!handoffChannel_->isNoneEvent())
+        {
+            handoffChannel_->disableAll();
+            handoffChannel_->remove();
+        }
+        handoffChannel_.reset();
+    }
+    if (handoffFd_ >= 0)
+    {
+        ::close(handoffFd_);
+        handoffFd_ = -1;
+    }
+    if (accessLog_)
+    {
+        accessLog_->stop();
+    }
+}
+
+// 排空：停止 accept，空闲的长连接立即关闭，正在处理的请求完成后关闭连接，
+// 超过 timeoutSeconds 还没结束的连接强制关闭，所有连接关闭后 start() 返回
+void HttpServer::drain(double timeoutSeconds)
+{
+    mainLoop_.runInLoop(std::bind(&HttpServer::drainInLoop, this, timeoutSeconds));
+}
+
+void HttpServer::drainInLoop(double timeoutSeconds)
+{
+    mainLoop_.assertInLoopThread();
+    if (draining_.exchange(true))
+    {
+        return;
+    }
+    LOG_WARN << "HttpServer[" << name_ << "] draining " << activeConnections_.load()
+             << " connections, deadline " << timeoutSeconds << "s";
+
+    for (auto& listener : listeners_)
+    {
+        listener->getLoop()->runInLoop(std::bind(&HttpListener::stopAccepting, listener.get()));
+    }
+    for (auto& item : loops_)
+    {
+        item.first->runInLoop(std::bind(&HttpServer::closeConnectionsInLoop, this, item.first, false));
+    }
+    mainLoop_.runAfter(timeoutSeconds, std::bind(&HttpServer::onDrainDeadline, this));
+    mainLoop_.runEvery(0.1, std::bind(&HttpServer::checkDrained, this));
+}
+
+// force 为 false 时只关闭空闲连接，为 true 时关闭全部连接
+void HttpServer::closeConnectionsInLoop(muduo::net::EventLoop *loop, bool force)
+{
+    // 关闭过程中会回调 onConnection 修改集合，先拷贝一份
+    std::vector<muduo::net::TcpConnectionPtr> conns(loops_.at(loop)->connections.begin(),
+                                                    loops_.at(loop)->connections.end());
+    for (const auto &conn : conns)
+    {
+        if (force)
+        {
+            conn->forceClose();
+            continue;
+        }
+        HttpContext *context = connectionContext(conn);
+        if (isIdle(conn, context))
+        {
+            conn->shutdown();
+        }
+    }
+}
+
+bool HttpServer::isIdle(const muduo::net::TcpConnectionPtr &conn, const HttpContext *context) const
+{
+    return !context->pending() && !context->sendingBody()
+        && !context->expectingHeaders() && !context->expectingBody()
+        && conn->outputBuffer()->readableBytes() == 0
+        && conn->inputBuffer()->readableBytes() == 0;
+}
+
+void HttpServer::onDrainDeadline()
+{
+    LOG_WARN << "HttpServer[" << name_ << "] drain deadline reached, closing "
+             << activeConnections_.load() << " connections";
+    for (auto& item : loops_)
+    {
+        item.first->runInLoop(std::bind(&HttpServer::closeConnectionsInLoop, this, item.first, true));
+    }
+    // 强制关闭是异步完成的，留一点时间给各个 IO 线程
+    mainLoop_.runAfter(1.0, std::bind(&muduo::net::EventLoop::quit, &mainLoop_));
+}
+
+void HttpServer::checkDrained()
+{
+    if (activeConnections_.load() == 0 && pendingBlocking_.load() == 0)
+    {
+        mainLoop_.quit();
+    }
+}
+
+// SIGTERM / SIGINT 触发排空；配置了交接路径时，等待新进程来取监听套接字
+void HttpServer::startShutdownHandlers()
+{
+    if (gracefulShutdown_)
+    {
+        shutdownFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        g_shutdownEventFd = shutdownFd_;
+        struct sigaction sa;
+        ::memset(&sa, 0, sizeof sa);
+        sa.sa_handler = onShutdownSignal;
+        ::sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        ::sigaction(SIGTERM, &sa, nullptr);
+        ::sigaction(SIGINT, &sa, nullptr);
+        shutdownChannel_ = std::make_unique<muduo::net::Channel>(&mainLoop_, shutdownFd_);
+        shutdownChannel_->setReadCallback(std::bind(&HttpServer::onShutdownSignalRead, this));
+        shutdownChannel_->enableReading();
+    }
+
+    if (!handoffPath_.empty())
+    {
+        handoffFd_ = handoff::listenHandoffSocket(handoffPath_);
+        if (handoffFd_ >= 0)
+        {
+            handoffChannel_ = std::make_unique<muduo::net::Channel>(&mainLoop_, handoffFd_);
+            handoffChannel_->setReadCallback(std::bind(&HttpServer::onHandoffRequest, this));
+            handoffChannel_->enableReading();
+        }
+    }
+}
+
+void HttpServer::onShutdownSignalRead()
+{
+    uint64_t count;
+    ssize_t n = ::read(shutdownFd_, &count, sizeof count);
+    (void)n;
+    drainInLoop(drainTimeout_);
+}
+
+// 新进程连上交接套接字：把监听 fd 交给它，然后自己排空退出
+void HttpServer::onHandoffRequest()
+{
+    int sockfd = ::accept4(handoffFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (sockfd < 0)
+    {
+        return;
+    }
+    if (draining_)
+    {
+        // 监听套接字已经关闭，没有可交接的了
+        ::close(sockfd);
+        return;
+    }
+
+    std::vector<int> fds;
+    for (const auto& listener : listeners_)
+    {
+        fds.push_back(listener->fd());
+    }
+    bool ok = handoff::sendListenFds(sockfd, fds);
+    ::close(sockfd);
+    if (ok)
+    {
+        LOG_WARN << "HttpServer[" << name_ << "] handed " << fds.size() << " listen sockets to successor";
+        handoffChannel_->disableAll();
+        handoffChannel_->remove();
+        drainInLoop(drainTimeout_);
+    }
 }
 
 void HttpServer::initialize()
 {
-    // 设置回调函数
-    server_.setConnectionCallback(
-        std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
-    server_.setMessageCallback(
-        std::bind(&HttpServer::onMessage, this,
-                  std::placeholders::_1,
-                  std::placeholders::_2,
-                  std::placeholders::_3));
+    bodyOptions_.matchRoute = [this](HttpRequest &req) -> const router::Route * {
+        return httpCallback_ ? nullptr : router_.match(req);
+    };
     enableResponseCache(128ull*1024*1024, 120, 30);
 }
 
+void HttpServer::startListeners(const std::vector<int>& inheritedFds)
+{
+    threadPool_ = std::make_unique<muduo::net::EventLoopThreadPool>(&mainLoop_, name_);
+    threadPool_->setThreadNum(numThreads_);
+    threadPool_->start();
+    // 每个 IO 线程每秒刷新一次自己的 Date 头部缓存，并转动自己的空闲连接时间轮
+    int maxTimeout = std::max({headerTimeout_, bodyTimeout_, keepAliveTimeout_});
+    for (muduo::net::EventLoop* loop : threadPool_->getAllLoops())
+    {
+        loop->runInLoop(std::bind(&HttpDate::startTicking, loop));
+        // 连接建立之前就建好，之后 map 本身只读，IO 线程查找时不需要加锁
+        auto state = std::make_unique<LoopState>();
+        if (maxTimeout > 0)
+        {
+            state->wheel = std::make_unique<TimingWheel>(loop, maxTimeout);
+            loop->runInLoop(std::bind(&TimingWheel::start, state->wheel.get()));
+        }
+        loops_[loop] = std::move(state);
+    }
+
+    std::vector<muduo::net::EventLoop*> acceptLoops;
+    if (shardedListen_ && numThreads_ > 0)
+    {
+        // 每个 IO 线程一个 SO_REUSEPORT 监听器，连接就留在 accept 它的线程上
+        acceptLoops = threadPool_->getAllLoops();
+    }
+    else
+    {
+        // 单个监听器挂在主循环上，新连接轮询分发给 IO 线程
+        acceptLoops.push_back(&mainLoop_);
+    }
+
+    // 交接过来的监听套接字一个都不能丢（它们的队列里可能已经有连接），数量多于 accept 线程时轮流分配
+    size_t numListeners = std::max(acceptLoops.size(), inheritedFds.size());
+    for (size_t i = 0; i < numListeners; ++i)
+    {
+        muduo::net::EventLoop* loop = acceptLoops[i % acceptLoops.size()];
+        bool sharded = (loop != &mainLoop_);
+        std::string listenerName = sharded ? name_ + "-shard" + std::to_string(i) : name_;
+        std::shared_ptr<HttpListener> listener;
+        if (i < inheritedFds.size())
+        {
+            listener = std::make_shared<HttpListener>(loop, inheritedFds[i], listenerName);
+        }
+        else
+        {
+            listener = std::make_shared<HttpListener>(loop, listenAddr_, listenerName, sharded || reusePort_);
+        }
+        if (!sharded)
+        {
+            listener->setIoLoopPool(threadPool_.get());
+        }
+        listener->setConnectionCallback(
+            std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
+        listener->setMessageCallback(
+            std::bind(&HttpServer::onMessage, this,
+                      std::placeholders::_1,
+                      std::placeholders::_2,
+                      std::placeholders::_3));
+        listener->setNewConnectionCallback(
+            [this](const muduo::net::TcpConnectionPtr& conn, int sockfd) {
+                conn->setContext(std::make_shared<HttpContext>(sockfd, &bodyOptions_));
+            });
+        loop->runInLoop(std::bind(&HttpListener::start, listener.get()));
+        listeners_.push_back(std::move(listener));
+    }
+}
+
 void HttpServer::setSslConfig(const ssl::SslConfig& config)
 {
     if (useSSL_)
@@ -73,7 +510,22 @@ void HttpServer::onConnection(const muduo::net::TcpConnectionPtr& conn)
             sslConns_[conn] = std::move(sslConn);
             sslConns_[conn]->startHandshake();
         }
-        conn->setContext(HttpContext());
+        // 上下文（含 socket fd）已在 HttpListener 创建连接时设置
+        conn->setWriteCompleteCallback(
+            std::bind(&HttpServer::onWriteComplete, this, std::placeholders::_1));
+        conn->setHighWaterMarkCallback(
+            std::bind(&HttpServer::onHighWaterMark, this, std::placeholders::_1, std::placeholders::_2),
+            outputHighWaterMark_);
+        HttpContext *context = connectionContext(conn);
+        LoopState *state = loops_.at(conn->getLoop()).get();
+        state->connections.insert(conn);
+        activeConnections_.fetch_add(1);
+        if (state->wheel)
+        {
+            context->setIdleWheel(state->wheel.get());
+            // 新连接必须在请求头超时内发来第一个请求
+            armIdleTimer(conn, context, HttpContext::kIdleHeader);
+        }
     }
     else 
     {
@@ -81,6 +533,19 @@ void HttpServer::onConnection(const muduo::net::TcpConnectionPtr& conn)
         {
             sslConns_.erase(conn);
         }
+        if (loops_.at(conn->getLoop())->connections.erase(conn) > 0)
+        {
+            activeConnections_.fetch_sub(1);
+        }
+        // 连接断开时把它还计在总量里的输出积压扣掉
+        HttpContext *context = connectionContext(conn);
+        bufferedOutputBytes_.fetch_sub(context->reportedOutputBytes());
+        context->setReportedOutputBytes(0);
+        if (context->backpressured())
+        {
+            context->setBackpressured(false);
+            pausedConnections_.fetch_sub(1);
+        }
     }
 }
 
@@ -88,24 +553,24 @@ void HttpServer::onMessage(const muduo::net::TcpConnectionPtr &conn,
                            muduo::net::Buffer *buf,
                            muduo::Timestamp receiveTime)
 {
+    muduo::net::Buffer output; // 本次读事件中所有响应的合并输出
+    HttpContext *context = nullptr;
+    bool close = false;
     try
     {
         // 这层判断只是代表是否支持ssl
         if (useSSL_)
         {
-            LOG_INFO << "onMessage useSSL_ is true";
             // 1.查找对应的SSL连接
             auto it = sslConns_.find(conn);
             if (it != sslConns_.end())
             {
-                LOG_INFO << "onMessage sslConns_ is not empty";
                 // 2. SSL连接处理数据
                 it->second->onRead(conn, buf, receiveTime);
 
                 // 3. 如果 SSL 握手还未完成，直接返回
                 if (!it->second->isHandshakeCompleted())
                 {
-                    LOG_INFO << "onMessage sslConns_ is not empty";
                     return;
                 }
 
@@ -116,88 +581,760 @@ void HttpServer::onMessage(const muduo::net::TcpConnectionPtr &conn,
 
                 // 5. 使用解密后的数据进行HTTP 处理
                 buf = decryptedBuf; // 将 buf 指向解密后的数据
-                LOG_INFO << "onMessage decryptedBuf is not empty";
             }
         }
         // HttpContext对象用于解析出buf中的请求报文，并把报文的关键信息封装到HttpRequest对象中
-        HttpContext *context = boost::any_cast<HttpContext>(conn->getMutableContext());
-        if (!context->parseRequest(buf, receiveTime)) // 解析一个http请求
+        context = connectionContext(conn);
+        // 一次读事件里可能带了多个流水线请求：逐个解析直到缓冲区取完，
+        // 所有响应按请求顺序追加到同一个输出缓冲区，最后一次性发送
+        while (!close && !context->pending() && !context->backpressured() && buf->readableBytes() > 0)
         {
-            // 如果解析http报文过程中出错
-            conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-            conn->shutdown();
-        }
-        // 如果buf缓冲区中解析出一个完整的数据包才封装响应报文
-        if (context->gotAll())
-        {
-            onRequest(conn, context->request());
+            if (!context->parseRequest(buf, receiveTime)) // 解析一个http请求
+            {
+                // 如果解析http报文过程中出错
+                appendParseError(context->errorStatus(), &output);
+                close = true;
+                break;
+            }
+            // 请求还不完整，等下一次可读事件
+            if (!context->gotAll())
+            {
+                break;
+            }
+            // 路由只匹配一次，结果既决定在哪个线程处理，也直接用于之后的分发；
+            // 带请求体的请求在收请求体之前已经匹配过（为了找增量回调），直接沿用
+            HttpRequest &req = context->request();
+            const router::Route *route = nullptr;
+            if (context->routeMatched())
+            {
+                route = context->matchedRoute();
+            }
+            else if (!httpCallback_)
+            {
+                route = router_.match(req);
+            }
+            if (workerPool_ && route && route->blocking)
+            {
+                // 阻塞型路由：中间件和缓存先在 IO 线程上处理，缓存命中或中间件直接回复的请求不进工作线程池
+                HttpResponse response(requestWantsClose(req));
+                metrics::RequestTrace::current().begin(context->parseNanos());
+                if (handleBeforeRoute(req, &response))
+                {
+                    close = writeResponse(conn, context, response, &output);
+                }
+                // 请求留在上下文里交给工作线程，完成前暂停解析后续请求，处理完成回到 IO 线程后才 reset
+                else if (dispatchBlocking(conn, route, std::move(response), context->parseNanos()))
+                {
+                    context->setPending(true);
+                    break;
+                }
+                else
+                {
+                    // 工作队列已满，直接返回 503，不在 IO 线程里执行阻塞处理器
+                    close = onOverloaded(req, &output);
+                    context->reset();
+                    continue;
+                }
+            }
+            else
+            {
+                close = onRequest(conn, context, route, &output);
+            }
             context->reset();
+            // 流水线请求的响应积压超过高水位：先把攒下的响应发出去，
+            // socket 写不完就暂停读和解析，等输出缓冲区排空后在 onWriteComplete 中恢复
+            if (!close && output.readableBytes() + conn->outputBuffer()->readableBytes() >= outputHighWaterMark_)
+            {
+                conn->send(&output);
+                if (conn->outputBuffer()->readableBytes() > 0)
+                {
+                    pauseReading(conn, context);
+                }
+            }
         }
     }
     catch (const std::exception &e)
     {
         // 捕获异常，返回错误信息
         LOG_ERROR << "Exception in onMessage: " << e.what();
-        conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
+        output.append("HTTP/1.1 400 Bad Request\r\n\r\n");
+        close = true;
+    }
+
+    if (output.readableBytes() > 0)
+    {
+        conn->send(&output);
+    }
+    // 文件或流式响应体跟在头部之后发送，发完再决定是否关闭、继续解析
+    if (context && context->sendingBody())
+    {
+        sendBody(conn, context);
+        updateConnectionState(conn, context, buf);
+        return;
+    }
+    // 如果是短连接的话，返回响应报文后就断开连接，后面剩余的流水线请求不再处理
+    if (close)
+    {
         conn->shutdown();
+        return;
+    }
+    if (context)
+    {
+        updateConnectionState(conn, context, buf);
     }
 }
 
-void HttpServer::onRequest(const muduo::net::TcpConnectionPtr &conn, const HttpRequest &req)
+// 在 IO 线程中处理一个请求，把响应追加到 output 中，返回处理完后是否需要关闭连接
+bool HttpServer::onRequest(const muduo::net::TcpConnectionPtr &conn,
+                           HttpContext *context,
+                           const router::Route *route,
+                           muduo::net::Buffer *output)
 {
-    const std::string &connection = req.getHeader("Connection");
-    bool close = ((connection == "close") ||
-                  (req.getVersion() == "HTTP/1.0" && connection != "Keep-Alive"));
-    HttpResponse response(close);
+    HttpRequest &req = context->request();
+    HttpResponse response(requestWantsClose(req));
+    metrics::RequestTrace::current().begin(context->parseNanos());
 
     // 根据请求报文信息来封装响应报文对象
-    httpCallback_(req, &response); // 执行onHttpCallback函数
+    dispatchRequest(req, route, &response);
+    return writeResponse(conn, context, response, output);
+}
+
+// 序列化已经生成的响应并安排响应体的发送，返回处理完后是否需要关闭连接
+bool HttpServer::writeResponse(const muduo::net::TcpConnectionPtr &conn,
+                               HttpContext *context,
+                               HttpResponse &response,
+                               muduo::net::Buffer *output)
+{
+    HttpRequest &req = context->request();
+    metrics::RequestTrace &trace = metrics::RequestTrace::current();
+    if (draining_)
+    {
+        // 排空期间每个响应之后都关闭连接，客户端会重新连到新进程
+        response.setCloseConnection(true);
+    }
+    bool chunked = response.hasChunkedBody() && prepareChunkedBody(req, &response);
+
+    // output 里可能已经有前面流水线请求的响应
+    size_t responseStart = output->readableBytes();
+    {
+        metrics::StageTimer timer(metrics::kSerialize);
+        response.appendHeadersToBuffer(output);
+    }
+    if (accessLog_)
+    {
+        accessLog_->log(conn, req, response.getStatusCode(), responseBodyBytes(response));
+    }
+
+    // 文件响应体：头部已经在 output 里，文件内容挂到连接上下文，由 sendFileBody 发送
+    if (response.hasFileBody())
+    {
+        if (useSSL_)
+        {
+            // TLS 连接无法 sendfile，退化为读进输出缓冲区
+            if (!appendFileBody(*response.fileBody(), responseStart, output))
+            {
+                trace.finish();
+                return true;
+            }
+        }
+        else
+        {
+            context->setFileBody(response.fileBody(), response.closeConnection());
+            trace.finish();
+            return false;
+        }
+    }
+    else if (response.hasChunkedBody())
+    {
+        if (useSSL_)
+        {
+            drainChunkedBody(response.chunkedBody(), chunked, output);
+        }
+        else
+        {
+            // 头部先随 output 发出，响应体在 sendChunkedBody 中按输出缓冲区的排空节奏生成
+            context->setChunkedBody(response.chunkedBody(), chunked, response.closeConnection());
+            trace.finish();
+            return false;
+        }
+    }
+    else if (!useSSL_ && response.bodyView().size() >= kWritevBodyThreshold)
+    {
+        // 大响应体不拷贝进输出缓冲区，和已攒下的头部一起 writev 出去
+        writeWithBody(conn, context->sockfd(), output, response.bodyView());
+    }
+    else
+    {
+        // 小响应体拷贝一次的代价比多一次系统调用小，继续和流水线中的其它响应合并发送
+        metrics::StageTimer timer(metrics::kSerialize);
+        std::string_view body = response.bodyView();
+        output->append(body.data(), body.size());
+    }
+    trace.finish();
+    return response.closeConnection();
+}
+
+// output 中的数据和 body 用一次 writev 发送，写不完的部分交给 muduo 的输出缓冲区
+void HttpServer::writeWithBody(const muduo::net::TcpConnectionPtr &conn, int sockfd,
+                               muduo::net::Buffer *output, std::string_view body)
+{
+    size_t written = 0;
+    // muduo 输出缓冲区里还有数据时直接写 socket 会乱序
+    if (conn->outputBuffer()->readableBytes() == 0)
+    {
+        struct iovec vec[2];
+        vec[0].iov_base = const_cast<char *>(output->peek());
+        vec[0].iov_len = output->readableBytes();
+        vec[1].iov_base = const_cast<char *>(body.data());
+        vec[1].iov_len = body.size();
+        ssize_t n;
+        do
+        {
+            n = ::writev(sockfd, vec, 2);
+        } while (n < 0 && errno == EINTR);
+        // EAGAIN 或其它错误都交给 send，由 muduo 处理可写事件和连接错误
+        written = n > 0 ? static_cast<size_t>(n) : 0;
+    }
+
+    size_t headLen = output->readableBytes();
+    if (written < headLen)
+    {
+        output->retrieve(written);
+        conn->send(output);
+        written = headLen;
+    }
+    else
+    {
+        output->retrieveAll();
+    }
+    size_t bodyWritten = written - headLen;
+    if (bodyWritten < body.size())
+    {
+        conn->send(body.data() + bodyWritten, static_cast<int>(body.size() - bodyWritten));
+    }
+}
+
+// 用 sendfile 把文件从缓存的 fd 直接发到 socket，不经过用户态缓冲区
+void HttpServer::sendFileBody(const muduo::net::TcpConnectionPtr &conn, HttpContext *context)
+{
+    static const size_t kSendfileChunk = 1024 * 1024;
+
+    // muduo 输出缓冲区里还有数据时不能直接写 socket，等 onWriteComplete 再继续
+    while (context->fileRemaining() > 0 && conn->outputBuffer()->readableBytes() == 0)
+    {
+        ssize_t n = ::sendfile(context->sockfd(), context->file()->fd(), context->fileOffset(),
+                               std::min(context->fileRemaining(), kSendfileChunk));
+        if (n > 0)
+        {
+            context->fileRemaining() -= n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            // 内核发送缓冲区满了：读一小块交给 muduo 发送，由它关注可写事件，
+            // 写完后回调 onWriteComplete 继续 sendfile
+            static const size_t kFallbackChunk = 64 * 1024;
+            size_t len = std::min(context->fileRemaining(), kFallbackChunk);
+            muduo::net::Buffer chunk;
+            chunk.ensureWritableBytes(len);
+            ssize_t r = ::pread(context->file()->fd(), chunk.beginWrite(), len, *context->fileOffset());
+            if (r > 0)
+            {
+                chunk.hasWritten(r);
+                *context->fileOffset() += r;
+                context->fileRemaining() -= r;
+                conn->send(&chunk);
+                return;
+            }
+        }
+        // 出错或文件被截断，Content-Length 已经发出去了，只能断开连接
+        LOG_SYSERR << "sendfile failed on " << conn->name();
+        context->clearFileBody();
+        conn->forceClose();
+        return;
+    }
+
+    if (context->fileRemaining() > 0)
+    {
+        return;
+    }
+    finishBody(conn, context);
+}
+
+// 生成一轮流式响应体并发送：只在输出缓冲区为空时生成，发不完的部分留在输出缓冲区，
+// 排空后 onWriteComplete 再生成下一轮，所以内存里最多只有一轮的数据
+void HttpServer::sendChunkedBody(const muduo::net::TcpConnectionPtr &conn, HttpContext *context)
+{
+    static const size_t kChunkedRoundBytes = 256 * 1024;
+
+    // 生产函数在等外部数据时由 resumer 唤醒，期间的 onWriteComplete 不再调用它
+    if (context->streamWaiting() || conn->outputBuffer()->readableBytes() > 0)
+    {
+        return;
+    }
+    muduo::net::Buffer round;
+    ChunkedWriter writer(&round, context->streamChunked());
+    writer.setResumer(std::bind(&HttpServer::queueChunkedResume, this,
+                                std::weak_ptr<muduo::net::TcpConnection>(conn),
+                                conn->getLoop(), context->streamGeneration()));
+    // 一轮不超过输出高水位，慢速客户端积压的数据不会超过暂停读取的阈值
+    size_t roundLimit = std::min(kChunkedRoundBytes, std::max<size_t>(outputHighWaterMark_, 1));
+    ChunkedStatus status = ChunkedStatus::kMore;
+    try
+    {
+        // 一轮攒够再发，一次 send 只会触发一次 onWriteComplete；一次调用没写出数据就结束本轮，不在 IO 线程里空转
+        while (round.readableBytes() < roundLimit)
+        {
+            size_t before = writer.bytesWritten();
+            status = context->chunkedBody()(&writer);
+            if (status != ChunkedStatus::kMore || writer.bytesWritten() == before)
+            {
+                break;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // 头部已经发出去了，只能断开连接让客户端知道响应不完整
+        LOG_ERROR << "Exception in chunked body of " << conn->name() << ": " << e.what();
+        context->clearChunkedBody();
+        conn->forceClose();
+        return;
+    }
+    if (status == ChunkedStatus::kDone)
+    {
+        writer.finish();
+    }
+    bool sent = round.readableBytes() > 0;
+    if (sent)
+    {
+        conn->send(&round);
+    }
+    if (status == ChunkedStatus::kDone)
+    {
+        finishBody(conn, context);
+        return;
+    }
+    if (status == ChunkedStatus::kWouldBlock)
+    {
+        context->setStreamWaiting(true);
+        return;
+    }
+    if (!sent)
+    {
+        // 说有数据却一个字节也没写，也不会有 onWriteComplete 触发下一轮：
+        // 排到本轮事件处理之后再试，先让其它连接跑
+        context->setStreamWaiting(true);
+        writer.resumer()();
+    }
+}
+
+// resumer 可能在任意线程、甚至在生产函数内部被调用，一律排队到连接所属的 IO 线程，
+// 不在当前调用栈里重入 sendChunkedBody。服务器停止后不能再调用
+void HttpServer::queueChunkedResume(const std::weak_ptr<muduo::net::TcpConnection> &weakConn,
+                                    muduo::net::EventLoop *loop,
+                                    uint64_t generation)
+{
+    loop->queueInLoop(std::bind(&HttpServer::resumeChunkedBody, this, weakConn, generation));
+}
+
+void HttpServer::resumeChunkedBody(const std::weak_ptr<muduo::net::TcpConnection> &weakConn,
+                                   uint64_t generation)
+{
+    muduo::net::TcpConnectionPtr conn = weakConn.lock();
+    if (!conn || !conn->connected())
+    {
+        return;
+    }
+    HttpContext *context = connectionContext(conn);
+    // 响应已经结束或换成了下一个响应，迟到的唤醒直接丢弃
+    if (!context->sendingChunked() || !context->streamWaiting()
+        || context->streamGeneration() != generation)
+    {
+        return;
+    }
+    context->setStreamWaiting(false);
+    sendChunkedBody(conn, context);
+    updateConnectionState(conn, context, conn->inputBuffer());
+}
+
+void HttpServer::sendBody(const muduo::net::TcpConnectionPtr &conn, HttpContext *context)
+{
+    if (context->sendingFile())
+    {
+        sendFileBody(conn, context);
+    }
+    else
+    {
+        sendChunkedBody(conn, context);
+    }
+}
+
+// 文件或流式响应体发送完毕，按响应的要求关闭连接或继续解析流水线中的下一个请求
+void HttpServer::finishBody(const muduo::net::TcpConnectionPtr &conn, HttpContext *context)
+{
+    bool close = context->closeAfterBody();
+    context->clearFileBody();
+    context->clearChunkedBody();
+    if (close)
+    {
+        conn->shutdown();
+        return;
+    }
+    resumeParsing(conn);
+}
+
+void HttpServer::onWriteComplete(const muduo::net::TcpConnectionPtr &conn)
+{
+    HttpContext *context = connectionContext(conn);
+    bool resume = false;
+    if (context->backpressured())
+    {
+        // 输出积压已经排空，恢复读取
+        context->setBackpressured(false);
+        pausedConnections_.fetch_sub(1);
+        conn->startRead();
+        resume = true;
+    }
+    if (context->sendingBody())
+    {
+        sendBody(conn, context);
+    }
+    else if (resume)
+    {
+        // 暂停期间留在输入缓冲区里的流水线请求继续解析
+        resumeParsing(conn);
+        return;
+    }
+    // 客户端在读走响应，刷新超时
+    updateConnectionState(conn, context, conn->inputBuffer());
+}
+
+// 输出缓冲区超过高水位（如慢速客户端读一个大响应）：不再读新请求，避免积压无限增长
+void HttpServer::onHighWaterMark(const muduo::net::TcpConnectionPtr &conn, size_t len)
+{
+    HttpContext *context = connectionContext(conn);
+    // 高水位回调是排队执行的，执行时缓冲区可能已经写空了
+    if (conn->connected() && conn->outputBuffer()->readableBytes() > 0)
+    {
+        LOG_DEBUG << conn->name() << " output backlog " << len << " bytes, pause reading";
+        pauseReading(conn, context);
+        updateOutputGauge(conn, context);
+    }
+}
+
+void HttpServer::pauseReading(const muduo::net::TcpConnectionPtr &conn, HttpContext *context)
+{
+    if (!context->backpressured())
+    {
+        context->setBackpressured(true);
+        pausedConnections_.fetch_add(1);
+        conn->stopRead();
+    }
+}
+
+// 把连接当前的输出积压同步到全局计数上，只记增量，不需要遍历连接
+void HttpServer::updateOutputGauge(const muduo::net::TcpConnectionPtr &conn, HttpContext *context)
+{
+    size_t current = conn->outputBuffer()->readableBytes();
+    size_t reported = context->reportedOutputBytes();
+    if (current > reported)
+    {
+        bufferedOutputBytes_.fetch_add(current - reported, std::memory_order_relaxed);
+    }
+    else if (current < reported)
+    {
+        bufferedOutputBytes_.fetch_sub(reported - current, std::memory_order_relaxed);
+    }
+    context->setReportedOutputBytes(current);
+}
+
+// 之前暂停解析期间到达的流水线请求还留在输入缓冲区里，继续解析
+void HttpServer::resumeParsing(const muduo::net::TcpConnectionPtr &conn)
+{
+    if (!useSSL_ && conn->connected() && conn->inputBuffer()->readableBytes() > 0)
+    {
+        onMessage(conn, conn->inputBuffer(), muduo::Timestamp::now());
+        return;
+    }
+    updateConnectionState(conn, connectionContext(conn), conn->inputBuffer());
+}
+
+// 一轮读写处理完后更新连接的输出积压计数，并根据连接当前所处的阶段决定挂哪一种超时
+void HttpServer::updateConnectionState(const muduo::net::TcpConnectionPtr &conn,
+                                 HttpContext *context,
+                                 const muduo::net::Buffer *buf)
+{
+    updateOutputGauge(conn, context);
+
+    HttpContext::IdlePhase phase;
+    if (context->sendingBody() || conn->outputBuffer()->readableBytes() > 0)
+    {
+        phase = HttpContext::kIdleKeepAlive; // 等待客户端读走响应
+    }
+    else if (context->pending())
+    {
+        phase = HttpContext::kIdleNone; // 工作线程处理中，处理时间不算作空闲
+    }
+    else if (context->expectingBody())
+    {
+        phase = HttpContext::kIdleBody;
+    }
+    else if (context->expectingHeaders() || buf->readableBytes() > 0)
+    {
+        phase = HttpContext::kIdleHeader;
+    }
+    else
+    {
+        phase = HttpContext::kIdleKeepAlive;
+    }
+    armIdleTimer(conn, context, phase);
+}
+
+// 连接挂到时间轮上：同一阶段内刷新原来的条目，换阶段时作废旧条目重新挂一个，都是 O(1) 且只在 IO 线程中执行
+void HttpServer::armIdleTimer(const muduo::net::TcpConnectionPtr &conn,
+                              HttpContext *context,
+                              HttpContext::IdlePhase phase)
+{
+    TimingWheel *wheel = context->idleWheel();
+    if (!wheel)
+    {
+        return;
+    }
+
+    int timeout = 0;
+    switch (phase)
+    {
+        case HttpContext::kIdleHeader:    timeout = headerTimeout_; break;
+        case HttpContext::kIdleBody:      timeout = bodyTimeout_; break;
+        case HttpContext::kIdleKeepAlive: timeout = keepAliveTimeout_; break;
+        case HttpContext::kIdleNone:      break;
+    }
+
+    IdleEntryPtr entry = context->idleEntry();
+    if (entry && phase == context->idlePhase())
+    {
+        // 请求头超时从开始接收算起，慢速客户端一个字节一个字节地发也不会延长
+        if (phase != HttpContext::kIdleHeader)
+        {
+            wheel->add(entry, timeout);
+        }
+        return;
+    }
+    if (entry)
+    {
+        entry->cancel();
+        entry.reset();
+    }
+    if (timeout > 0)
+    {
+        entry = std::make_shared<IdleEntry>(conn);
+        wheel->add(entry, timeout);
+    }
+    context->setIdleEntry(phase, entry);
+}
+
+bool HttpServer::dispatchBlocking(const muduo::net::TcpConnectionPtr &conn, const router::Route *route,
+                                  HttpResponse &&response, uint64_t parseNanos)
+{
+    HttpContextPtr context = boost::any_cast<HttpContextPtr>(conn->getContext());
+    // 队列深度超限：不再排队，由调用方直接返回 503
+    if (pendingBlocking_.fetch_add(1) >= maxPendingBlocking_)
+    {
+        pendingBlocking_.fetch_sub(1);
+        LOG_WARN << "Worker queue full (" << maxPendingBlocking_ << "), shedding "
+                 << std::string(context->request().path());
+        return false;
+    }
+
+    // 处理期间连接暂停解析，工作线程独占上下文中的请求对象
+    // 中间件已经写入的头部随响应对象一起交给工作线程
+    workerPool_->run(std::bind(&HttpServer::handleBlocking, this, conn, context, route,
+                               std::make_shared<HttpResponse>(std::move(response)), parseNanos));
+    return true;
+}
+
+bool HttpServer::onOverloaded(const HttpRequest &req, muduo::net::Buffer *output)
+{
+    HttpResponse response(requestWantsClose(req));
+    response.setStatusLine(req.getVersion(), HttpResponse::k503ServiceUnavailable, "Service Unavailable");
+    response.addHeader("Retry-After", "1");
+    response.setContentLength(0);
+    response.appendToBuffer(output);
+    return response.closeConnection();
+}
+
+// 在工作线程中执行
+void HttpServer::handleBlocking(const muduo::net::TcpConnectionPtr &conn,
+                                const HttpContextPtr &context,
+                                const router::Route *route,
+                                const std::shared_ptr<HttpResponse> &responsePtr,
+                                uint64_t parseNanos)
+{
+    HttpRequest *req = &context->request();
+    HttpResponse &response = *responsePtr;
+    metrics::RequestTrace &trace = metrics::RequestTrace::current();
+    trace.begin(parseNanos);
+    try
+    {
+        handleRoute(*req, route, &response);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR << "Exception in blocking handler: " << e.what();
+        response.setStatusLine(req->getVersion(), HttpResponse::k500InternalServerError, "Internal Server Error");
+        response.setCloseConnection(true);
+    }
+    if (draining_)
+    {
+        response.setCloseConnection(true);
+    }
+    bool chunked = response.hasChunkedBody() && prepareChunkedBody(*req, &response);
 
-    // 可以给response设置一个成员，判断是否请求的是文件，如果是文件设置为true，并且存在文件位置在这里send出去。
-    muduo::net::Buffer buf;
-    response.appendToBuffer(&buf);
-    // 打印完整的响应内容用于调试
-    LOG_INFO << "Sending response:\n" << buf.toStringPiece().as_string();
+    // 序列化也在工作线程完成，IO 线程只负责发送
+    auto output = std::make_shared<muduo::net::Buffer>();
+    {
+        metrics::StageTimer timer(metrics::kSerialize);
+        response.appendToBuffer(output.get());
+    }
+    trace.finish();
+    if (accessLog_)
+    {
+        accessLog_->log(conn, *req, response.getStatusCode(), responseBodyBytes(response));
+    }
+    CachedFilePtr file = response.fileBody();
+    ChunkedBodyCallback stream = response.chunkedBody();
+    if (file && useSSL_)
+    {
+        if (!appendFileBody(*file, 0, output.get()))
+        {
+            response.setCloseConnection(true);
+        }
+        file.reset();
+    }
+    if (stream && useSSL_)
+    {
+        drainChunkedBody(stream, chunked, output.get());
+        stream = nullptr;
+    }
+    pendingBlocking_.fetch_sub(1);
+    conn->getLoop()->runInLoop(
+        std::bind(&HttpServer::onBlockingDone, this, conn, output, file, stream, chunked,
+                  response.closeConnection()));
+}
+
+// 回到连接所属的 IO 线程
+void HttpServer::onBlockingDone(const muduo::net::TcpConnectionPtr &conn,
+                                const std::shared_ptr<muduo::net::Buffer> &output,
+                                const CachedFilePtr &file,
+                                const ChunkedBodyCallback &stream,
+                                bool chunked,
+                                bool close)
+{
+    if (!conn->connected())
+    {
+        return;
+    }
 
-    conn->send(&buf);
-    // 如果是短连接的话，返回响应报文后就断开连接
-    if (response.closeConnection())
+    conn->send(output.get());
+    HttpContext *context = connectionContext(conn);
+    context->reset();
+    context->setPending(false);
+    if (file)
+    {
+        context->setFileBody(file, close);
+        sendFileBody(conn, context);
+        updateConnectionState(conn, context, conn->inputBuffer());
+        return;
+    }
+    if (stream)
+    {
+        // 流式响应体在 IO 线程中生成，生成函数里不要做阻塞操作
+        context->setChunkedBody(stream, chunked, close);
+        sendChunkedBody(conn, context);
+        updateConnectionState(conn, context, conn->inputBuffer());
+        return;
+    }
+    if (close)
     {
         conn->shutdown();
+        return;
     }
+    resumeParsing(conn);
 }
 
-// 执行请求对应的路由处理函数
-void HttpServer::handleRequest(const HttpRequest &req, HttpResponse *resp)
+// 设置了 httpCallback_ 时交给它，否则走中间件、缓存和路由；route 是已经匹配好的路由，没有匹配时为空
+void HttpServer::dispatchRequest(HttpRequest &req, const router::Route *route, HttpResponse *resp)
+{
+    if (httpCallback_)
+    {
+        httpCallback_(req, resp);
+    }
+    else if (!handleBeforeRoute(req, resp))
+    {
+        handleRoute(req, route, resp);
+    }
+}
+
+// 处理请求前的中间件和缓存查找，返回 true 表示响应已经生成，不需要再执行路由
+bool HttpServer::handleBeforeRoute(HttpRequest &req, HttpResponse *resp)
 {
     try
     {
-        // 处理请求前的中间件
-        HttpRequest mutableReq = req;
-        middlewareChain_.processBefore(mutableReq);
+        // 中间件直接给出回复（如 CORS 预检）时不再走缓存和路由
+        if (middlewareChain_.processBefore(req, *resp) == middleware::MiddlewareResult::kRespond)
+        {
+            return true;
+        }
 
-        // —— 命中缓存则直接返回 —— 
+        // —— 命中缓存则跳过路由；after 中间件照常执行，CORS 等按请求变化的头部不进缓存 —— 
         if (cache_ && cache_->before(req, resp)) {
-            return;
+            metrics::RequestTrace::current().setRoute(req.method(), &metrics::Metrics::kCacheHitRoute);
+            middlewareChain_.processAfter(req, *resp);
+            return true;
         }
+        return false;
+    }
+    catch (const HttpResponse& res)
+    {
+        *resp = res;
+    }
+    catch (const std::exception& e)
+    {
+        resp->setStatusCode(HttpResponse::k500InternalServerError);
+        resp->setBody(e.what());
+    }
+    return true;
+}
 
-        // 路由处理
-        if (!router_.route(mutableReq, resp))
+// 执行已匹配的路由处理函数（route 为空时回复 404），写入缓存后执行处理响应后的中间件
+void HttpServer::handleRoute(HttpRequest &req, const router::Route *route, HttpResponse *resp)
+{
+    try
+    {
+        if (route)
         {
-            LOG_INFO << "请求的啥，url：" << req.method() << " " << req.path();
-            LOG_INFO << "未找到路由，返回404";
+            router_.dispatch(*route, req, resp);
+        }
+        else
+        {
+            LOG_DEBUG << "未找到路由，返回404: " << req.method() << " " << std::string(req.path());
             resp->setStatusCode(HttpResponse::k404NotFound);
             resp->setStatusMessage("Not Found");
             resp->setCloseConnection(true);
         }
 
-        // 处理响应后的中间件
-        middlewareChain_.processAfter(*resp);
-
-        // —— 将最终响应写入缓存（包含 after 中间件加的头，例如 CORS）——
+        // —— 在 after 中间件之前写入缓存，缓存的内容与请求来源无关 ——
         if (cache_) {
             cache_->after(req, *resp);
         }
+
+        // 处理响应后的中间件
+        middlewareChain_.processAfter(req, *resp);
     }
     catch (const HttpResponse& res)
     {
@@ -210,6 +1347,39 @@ void HttpServer::handleRequest(const HttpRequest &req, HttpResponse *resp)
     }
 }
 
+// 以 Prometheus 文本格式输出各阶段耗时分位数和连接相关的计数
+void HttpServer::enableMetrics(const std::string &path)
+{
+    Get(path, [this](const HttpRequest &req, HttpResponse *resp) {
+        std::string body;
+        metrics::Metrics::getInstance().appendPrometheus(&body);
+        body.append("# HELP http_buffered_output_bytes Bytes queued in connection output buffers.\n"
+                    "# TYPE http_buffered_output_bytes gauge\n"
+                    "http_buffered_output_bytes ");
+        body.append(std::to_string(bufferedOutputBytes()));
+        body.append("\n# HELP http_paused_connections Connections paused by output backpressure.\n"
+                    "# TYPE http_paused_connections gauge\n"
+                    "http_paused_connections ");
+        body.append(std::to_string(pausedConnections()));
+        body.append("\n# HELP http_pending_blocking_requests Requests queued or running on the worker pool.\n"
+                    "# TYPE http_pending_blocking_requests gauge\n"
+                    "http_pending_blocking_requests ");
+        body.append(std::to_string(pendingBlocking_.load()));
+        body.append("\n");
+
+        resp->setStatusLine(req.getVersion(), HttpResponse::k200Ok, "OK");
+        resp->setCloseConnection(false);
+        resp->setContentType("text/plain; version=0.0.4");
+        resp->addHeader("Cache-Control", "no-store");
+        resp->setContentLength(body.size());
+        resp->setBody(body);
+    });
+}
+
+void HttpServer::enableAccessLog(const std::string &basename, int sampleEvery, off_t rollSize)
+{
+    accessLog_ = std::make_unique<AccessLog>(basename, rollSize, sampleEvery);
+}
 
 void HttpServer::enableResponseCache(size_t capacityBytes, int ttlSec, int swrSec)
 {
@@ -221,8 +1391,66 @@ void HttpServer::enableResponseCache(size_t capacityBytes, int ttlSec, int swrSe
   pol.staleWhileRevalidate  = std::chrono::seconds(swrSec);// 软过期窗口
   pol.varyAcceptEncoding    = true;                        // 建议开启
 
-  cacheStore_ = std::make_shared<MemoryCacheLRU>(pol.memoryCapacityBytes);
+  enableResponseCache(pol);
+}
+
+void HttpServer::enableResponseCache(const http::cache::CachePolicy &pol)
+{
+  using namespace http::cache;
+
+  if (pol.eviction == CachePolicy::Eviction::TinyLfu)
+    cacheStore_ = std::make_shared<TinyLfuCache>(pol.memoryCapacityBytes);
+  else if (pol.memoryShards > 1)
+    cacheStore_ = std::make_shared<ShardedCacheLRU>(pol.memoryCapacityBytes, pol.memoryShards, pol.clockRecency);
+  else
+    cacheStore_ = std::make_shared<MemoryCacheLRU>(pol.memoryCapacityBytes);
   cache_      = std::make_shared<CacheMiddleware>(pol, cacheStore_);
+  if (pol.backgroundRevalidate)
+    cache_->setRevalidator(std::bind(&HttpServer::revalidateCached, this,
+                                     std::placeholders::_1, std::placeholders::_2));
+}
+
+// 在处理软过期命中的线程中执行；返回 false 表示这次没有发起刷新。
+// 没有工作线程池时不刷新：在 IO 线程里重新执行路由会让这个线程上的所有连接一起等，
+// 条目照常在彻底过期后由下一个请求重新生成
+bool HttpServer::revalidateCached(const HttpRequest &req, const http::cache::CachedEntryPtr &stale)
+{
+    if (draining_ || !workerPool_)
+    {
+        return false;
+    }
+    // 和阻塞型请求共用队列上限，排空时也会等它完成
+    if (pendingBlocking_.fetch_add(1) >= maxPendingBlocking_)
+    {
+        pendingBlocking_.fetch_sub(1);
+        return false;
+    }
+    auto request = std::make_shared<HttpRequest>(req.clone());
+    workerPool_->run([this, request, stale] {
+        runRevalidation(request, stale);
+        pendingBlocking_.fetch_sub(1);
+    });
+    return true;
+}
+
+// 只重新执行路由，不经过中间件：缓存的内容本来就与中间件添加的按请求变化的头部无关
+void HttpServer::runRevalidation(const std::shared_ptr<HttpRequest> &req, const http::cache::CachedEntryPtr &stale)
+{
+    HttpResponse response(false);
+    try
+    {
+        router_.route(*req, &response);
+    }
+    catch (const HttpResponse &res)
+    {
+        response = res;
+    }
+    catch (const std::exception &e)
+    {
+        LOG_WARN << "Cache revalidation of " << std::string(req->path()) << " failed: " << e.what();
+        response.setStatusCode(HttpResponse::k500InternalServerError);
+    }
+    cache_->finishRevalidation(*req, response, stale);
 }
 
 
@@ -0,0 +1,182 @@
+#include "../../include/http/ListenerHandoff.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+namespace handoff
+{
+
+namespace
+{
+
+const int kMaxFds = 64; // 一次交接的监听 fd 上限，足够覆盖每个 IO 线程一个
+
+bool makeAddress(const std::string& path, struct sockaddr_un* addr)
+{
+    ::memset(addr, 0, sizeof *addr);
+    addr->sun_family = AF_UNIX;
+    if (path.size() >= sizeof addr->sun_path)
+    {
+        LOG_ERROR << "handoff socket path too long: " << path;
+        return false;
+    }
+    ::memcpy(addr->sun_path, path.data(), path.size());
+    return true;
+}
+
+} // namespace
+
+int listenHandoffSocket(const std::string& path)
+{
+    struct sockaddr_un addr;
+    if (!makeAddress(path, &addr))
+    {
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "handoff: socket failed";
+        return -1;
+    }
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) < 0 ||
+        ::listen(fd, 1) < 0)
+    {
+        LOG_SYSERR << "handoff: bind/listen " << path << " failed";
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendListenFds(int sockfd, const std::vector<int>& fds)
+{
+    if (fds.empty() || fds.size() > static_cast<size_t>(kMaxFds))
+    {
+        LOG_ERROR << "handoff: invalid listen fd count " << fds.size();
+        return false;
+    }
+
+    // 正文只带 fd 个数，fd 本身放在控制消息里
+    uint32_t count = static_cast<uint32_t>(fds.size());
+    struct iovec iov;
+    iov.iov_base = &count;
+    iov.iov_len = sizeof count;
+
+    union
+    {
+        char           buf[CMSG_SPACE(sizeof(int) * kMaxFds)];
+        struct cmsghdr align;
+    } control;
+    ::memset(&control, 0, sizeof control);
+
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    ::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+    ssize_t n;
+    do
+    {
+        n = ::sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n != static_cast<ssize_t>(sizeof count))
+    {
+        LOG_SYSERR << "handoff: sendmsg failed";
+        return false;
+    }
+    return true;
+}
+
+std::vector<int> receiveListenFds(const std::string& path)
+{
+    std::vector<int> fds;
+    struct sockaddr_un addr;
+    if (!makeAddress(path, &addr))
+    {
+        return fds;
+    }
+    int sockfd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sockfd < 0)
+    {
+        LOG_SYSERR << "handoff: socket failed";
+        return fds;
+    }
+    if (::connect(sockfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) < 0)
+    {
+        // 没有旧进程在运行，属于正常的冷启动
+        LOG_INFO << "handoff: no predecessor at " << path;
+        ::close(sockfd);
+        return fds;
+    }
+
+    // 旧进程可能卡住，不能让新进程无限期等下去
+    struct timeval timeout = { 5, 0 };
+    ::setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+
+    uint32_t count = 0;
+    struct iovec iov;
+    iov.iov_base = &count;
+    iov.iov_len = sizeof count;
+
+    union
+    {
+        char           buf[CMSG_SPACE(sizeof(int) * kMaxFds)];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+
+    ssize_t n;
+    do
+    {
+        n = ::recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    ::close(sockfd);
+    if (n != static_cast<ssize_t>(sizeof count))
+    {
+        LOG_SYSERR << "handoff: recvmsg from " << path << " failed";
+        return fds;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            size_t num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+            fds.assign(data, data + num);
+        }
+    }
+    if (fds.size() != count)
+    {
+        LOG_WARN << "handoff: expected " << count << " fds, got " << fds.size();
+    }
+    LOG_INFO << "handoff: inherited " << fds.size() << " listen sockets from " << path;
+    return fds;
+}
+
+} // namespace handoff
+} // namespace http
@@ -0,0 +1,63 @@
+#include "../../include/http/TimingWheel.h"
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/TcpConnection.h>
+
+namespace http
+{
+
+IdleEntry::~IdleEntry()
+{
+    if (cancelled_)
+    {
+        return;
+    }
+    muduo::net::TcpConnectionPtr conn = conn_.lock();
+    if (conn)
+    {
+        LOG_DEBUG << "idle timeout, closing " << conn->name();
+        conn->forceClose();
+    }
+}
+
+TimingWheel::TimingWheel(muduo::net::EventLoop* loop, int maxTimeout)
+    : loop_(loop)
+    , buckets_(maxTimeout + 1)
+    , cursor_(0)
+{}
+
+void TimingWheel::start()
+{
+    loop_->assertInLoopThread();
+    loop_->runEvery(1.0, std::bind(&TimingWheel::onTick, this));
+}
+
+void TimingWheel::add(const IdleEntryPtr& entry, int seconds)
+{
+    loop_->assertInLoopThread();
+    int bucket = static_cast<int>((cursor_ + seconds) % buckets_.size());
+    if (entry->bucket_ == bucket)
+    {
+        return;
+    }
+    entry->bucket_ = bucket;
+    buckets_[bucket].push_back(entry);
+}
+
+void TimingWheel::onTick()
+{
+    cursor_ = (cursor_ + 1) % buckets_.size();
+    std::vector<IdleEntryPtr> expired;
+    expired.swap(buckets_[cursor_]);
+    for (const auto& entry : expired)
+    {
+        // 还被后面的格子引用的条目，下次放回这一格时不能被当成重复刷新
+        if (entry->bucket_ == static_cast<int>(cursor_))
+        {
+            entry->bucket_ = -1;
+        }
+    }
+    // expired 析构时，不再被任何格子引用的条目随之释放并关闭连接
+}
+
+} // namespace http
@@ -0,0 +1,95 @@
+#include "../../include/metrics/Histogram.h"
+
+namespace http
+{
+namespace metrics
+{
+
+Histogram::Histogram()
+    : count_(0)
+    , sum_(0)
+{
+    for (auto& counter : counts_)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+int Histogram::bucketIndex(uint64_t value)
+{
+    if (value < static_cast<uint64_t>(kSubBuckets))
+    {
+        return static_cast<int>(value);
+    }
+    if (value >= (1ull << kMaxBits))
+    {
+        return kBuckets - 1;
+    }
+    // 最高位决定所在的 2 的幂区间，紧随其后的 kSubBucketBits 位决定子桶
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - kSubBucketBits;
+    return shift * kSubBuckets + static_cast<int>(value >> shift);
+}
+
+uint64_t Histogram::bucketUpperBound(int index)
+{
+    if (index < kSubBuckets)
+    {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / kSubBuckets - 1;
+    uint64_t sub = static_cast<uint64_t>(index - shift * kSubBuckets);
+    return ((sub + 1) << shift) - 1;
+}
+
+void HistogramSnapshot::merge(const Histogram& histogram)
+{
+    for (int i = 0; i < Histogram::kBuckets; ++i)
+    {
+        counts_[i] += histogram.counts_[i].load(std::memory_order_relaxed);
+    }
+    count_ += histogram.count_.load(std::memory_order_relaxed);
+    sum_ += histogram.sum_.load(std::memory_order_relaxed);
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other)
+{
+    for (int i = 0; i < Histogram::kBuckets; ++i)
+    {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+}
+
+uint64_t HistogramSnapshot::valueAtPercentile(double percentile) const
+{
+    // 合并时各桶是分别读取的，以桶计数之和为准
+    uint64_t total = 0;
+    for (uint64_t c : counts_)
+    {
+        total += c;
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < Histogram::kBuckets; ++i)
+    {
+        seen += counts_[i];
+        if (seen >= rank)
+        {
+            return Histogram::bucketUpperBound(i);
+        }
+    }
+    return Histogram::bucketUpperBound(Histogram::kBuckets - 1);
+}
+
+} // namespace metrics
+} // namespace http
@@ -0,0 +1,234 @@
+#include "../../include/metrics/Metrics.h"
+
+#include <stdio.h>
+
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace http
+{
+namespace metrics
+{
+
+namespace
+{
+
+const char* stageName(int stage)
+{
+    switch (stage)
+    {
+        case kParse:            return "parse";
+        case kMiddlewareBefore: return "middleware_before";
+        case kMiddlewareAfter:  return "middleware_after";
+        case kCacheLookup:      return "cache_lookup";
+        case kHandler:          return "handler";
+        case kSerialize:        return "serialize";
+        default:                return "unknown";
+    }
+}
+
+const char* methodName(HttpRequest::Method method)
+{
+    switch (method)
+    {
+        case HttpRequest::kGet:     return "GET";
+        case HttpRequest::kPost:    return "POST";
+        case HttpRequest::kHead:    return "HEAD";
+        case HttpRequest::kPut:     return "PUT";
+        case HttpRequest::kDelete:  return "DELETE";
+        case HttpRequest::kOptions: return "OPTIONS";
+        default:                    return "INVALID";
+    }
+}
+
+// 路由标签里的引号和反斜杠需要转义
+void appendLabelValue(std::string* out, const std::string& value)
+{
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out->push_back('\\');
+        }
+        out->push_back(c);
+    }
+}
+
+void appendSeconds(std::string* out, uint64_t nanos)
+{
+    char buf[32];
+    snprintf(buf, sizeof buf, "%.9f", static_cast<double>(nanos) / 1e9);
+    out->append(buf);
+}
+
+thread_local RequestTrace t_trace;
+
+} // namespace
+
+const std::string Metrics::kUnmatchedRoute = "(unmatched)";
+const std::string Metrics::kCacheHitRoute = "(cache)";
+
+RequestTrace& RequestTrace::current()
+{
+    return t_trace;
+}
+
+void RequestTrace::begin(uint64_t parseNanos)
+{
+    for (auto& nanos : nanos_)
+    {
+        nanos = 0;
+    }
+    nanos_[kParse] = parseNanos;
+    method_ = HttpRequest::kInvalid;
+    route_ = &Metrics::kUnmatchedRoute;
+}
+
+void RequestTrace::finish()
+{
+    Metrics& metrics = Metrics::getInstance();
+    for (int stage = 0; stage < kStageCount; ++stage)
+    {
+        if (nanos_[stage] > 0)
+        {
+            metrics.record(static_cast<Stage>(stage), method_, route_, nanos_[stage]);
+        }
+    }
+}
+
+struct Metrics::ThreadMetrics
+{
+    struct SeriesKey
+    {
+        int                 stage;
+        HttpRequest::Method method;
+        const std::string*  route;
+
+        bool operator==(const SeriesKey& other) const
+        {
+            return stage == other.stage && method == other.method && route == other.route;
+        }
+    };
+
+    struct SeriesKeyHash
+    {
+        size_t operator()(const SeriesKey& key) const
+        {
+            return std::hash<const void*>{}(key.route) * 31 + key.method * 8 + key.stage;
+        }
+    };
+
+    // 所属线程只在新增序列时加锁，导出时加锁遍历；查找和记录都不加锁
+    std::mutex                                                                mutex;
+    std::unordered_map<SeriesKey, std::unique_ptr<Histogram>, SeriesKeyHash> series;
+};
+
+Metrics::ThreadMetrics* Metrics::threadMetrics()
+{
+    thread_local ThreadMetrics* t_metrics = nullptr;
+    if (!t_metrics)
+    {
+        auto metrics = std::make_shared<ThreadMetrics>();
+        t_metrics = metrics.get();
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(std::move(metrics));
+    }
+    return t_metrics;
+}
+
+void Metrics::record(Stage stage, HttpRequest::Method method, const std::string* route, uint64_t nanos)
+{
+    ThreadMetrics* tm = threadMetrics();
+    ThreadMetrics::SeriesKey key{stage, method, route};
+    auto it = tm->series.find(key);
+    if (it == tm->series.end())
+    {
+        std::lock_guard<std::mutex> lock(tm->mutex);
+        it = tm->series.emplace(key, std::make_unique<Histogram>()).first;
+    }
+    it->second->record(nanos);
+}
+
+void Metrics::appendPrometheus(std::string* out)
+{
+    std::vector<std::shared_ptr<ThreadMetrics>> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads = threads_;
+    }
+
+    // (阶段, 方法, 路由) -> 合并后的直方图；按路由字符串归并，输出有序
+    using MergedKey = std::tuple<int, std::string, std::string>;
+    std::map<MergedKey, HistogramSnapshot> merged;
+    for (const auto& tm : threads)
+    {
+        std::lock_guard<std::mutex> lock(tm->mutex);
+        for (const auto& item : tm->series)
+        {
+            MergedKey key(item.first.stage, methodName(item.first.method), *item.first.route);
+            merged[key].merge(*item.second);
+        }
+    }
+
+    // 每个阶段再汇总一份不分路由的数据
+    std::map<int, HistogramSnapshot> stages;
+    for (const auto& item : merged)
+    {
+        stages[std::get<0>(item.first)].merge(item.second);
+    }
+
+    static const double kQuantiles[] = { 0.5, 0.99, 0.999 };
+    auto appendSeries = [out](const std::string& name, const std::string& labels,
+                              const HistogramSnapshot& snapshot) {
+        for (double q : kQuantiles)
+        {
+            char quantile[16];
+            snprintf(quantile, sizeof quantile, "%g", q);
+            out->append(name);
+            out->append("{");
+            out->append(labels);
+            out->append(",quantile=\"");
+            out->append(quantile);
+            out->append("\"} ");
+            appendSeconds(out, snapshot.valueAtPercentile(q * 100));
+            out->append("\n");
+        }
+        out->append(name);
+        out->append("_sum{");
+        out->append(labels);
+        out->append("} ");
+        appendSeconds(out, snapshot.sum());
+        out->append("\n");
+        out->append(name);
+        out->append("_count{");
+        out->append(labels);
+        out->append("} ");
+        out->append(std::to_string(snapshot.count()));
+        out->append("\n");
+    };
+
+    // 不分路由的汇总单独成一个指标：和分路由的序列放在同一个指标名下，
+    // 对 _count / _sum 求和时每个请求会被算两次；分位数无法从各路由的分位数合成，所以仍然单独导出
+    out->append("# HELP http_stage_duration_all_seconds Time spent in each request processing stage, all routes.\n");
+    out->append("# TYPE http_stage_duration_all_seconds summary\n");
+    for (const auto& item : stages)
+    {
+        std::string labels = std::string("stage=\"") + stageName(item.first) + "\"";
+        appendSeries("http_stage_duration_all_seconds", labels, item.second);
+    }
+
+    out->append("# HELP http_stage_duration_seconds Time spent in each request processing stage, per route.\n");
+    out->append("# TYPE http_stage_duration_seconds summary\n");
+    for (const auto& item : merged)
+    {
+        std::string labels = std::string("stage=\"") + stageName(std::get<0>(item.first))
+                           + "\",method=\"" + std::get<1>(item.first) + "\",route=\"";
+        appendLabelValue(&labels, std::get<2>(item.first));
+        labels.push_back('"');
+        appendSeries("http_stage_duration_seconds", labels, item.second);
+    }
+}
+
+} // namespace metrics
+} // namespace http
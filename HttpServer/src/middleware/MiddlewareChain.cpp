@@ -1,4 +1,5 @@
 #include "../../include/middleware/MiddlewareChain.h"
+#include "../../include/metrics/Metrics.h"
 #include <muduo/base/Logging.h>
 
 namespace http
@@ -11,16 +12,22 @@ void MiddlewareChain::addMiddleware(std::shared_ptr<Middleware> middleware)
     middlewares_.push_back(middleware);
 }
 
-void MiddlewareChain::processBefore(HttpRequest &request)
+MiddlewareResult MiddlewareChain::processBefore(HttpRequest &request, HttpResponse &response)
 {
+    metrics::StageTimer timer(metrics::kMiddlewareBefore);
     for (auto &middleware : middlewares_)
     {
-        middleware->before(request);
+        if (middleware->before(request, response) == MiddlewareResult::kRespond)
+        {
+            return MiddlewareResult::kRespond;
+        }
     }
+    return MiddlewareResult::kContinue;
 }
 
-void MiddlewareChain::processAfter(HttpResponse &response)
+void MiddlewareChain::processAfter(const HttpRequest &request, HttpResponse &response)
 {
+    metrics::StageTimer timer(metrics::kMiddlewareAfter);
     try
     {
         // 反向处理响应，以保持中间件的正确执行顺序
@@ -28,7 +35,7 @@ void MiddlewareChain::processAfter(HttpResponse &response)
         {
             if (*it)
             { // 添加空指针检查
-                (*it)->after(response);
+                (*it)->after(request, response);
             }
         }
     }
@@ -9,101 +9,130 @@ namespace http
 namespace middleware 
 {
 
-CorsMiddleware::CorsMiddleware(const CorsConfig& config) : config_(config) {}
+CorsMiddleware::CorsMiddleware(const CorsConfig& config)
+    : config_(config)
+    , reflectAnyOrigin_(false)
+{
+    // 来源列表为空或包含 "*" 表示允许任意来源
+    bool anyOrigin = config_.allowedOrigins.empty() ||
+                     std::find(config_.allowedOrigins.begin(), config_.allowedOrigins.end(), "*")
+                         != config_.allowedOrigins.end();
+    if (anyOrigin)
+    {
+        // 浏览器不接受带凭据的请求回 "*"，这种配置只能逐个回显请求的 Origin
+        reflectAnyOrigin_ = config_.allowCredentials;
+        anyOrigin_.reset(new OriginHeaders(
+            buildHeaders(reflectAnyOrigin_ ? std::string_view() : "*", reflectAnyOrigin_)));
+        return;
+    }
 
-void CorsMiddleware::before(HttpRequest& request) 
+    for (const auto& origin : config_.allowedOrigins)
+    {
+        origins_.emplace_back(new std::string(origin));
+        // 允许多个来源时响应内容随 Origin 变化，需要 Vary: Origin 让浏览器和代理分开缓存
+        originIndex_.emplace(*origins_.back(), buildHeaders(origin, true));
+    }
+}
+
+CorsMiddleware::OriginHeaders CorsMiddleware::buildHeaders(std::string_view allowOrigin, bool varyOrigin)
 {
-    LOG_DEBUG << "CorsMiddleware::before - Processing request";
-    
-    if (request.method() == HttpRequest::Method::kOptions)  //预检请求，返回允许response
+    std::string common;
+    if (!allowOrigin.empty())
     {
-        LOG_INFO << "Processing CORS preflight request";
-        HttpResponse response;
-        handlePreflightRequest(request, response);
-        throw response;
+        common.append("Access-Control-Allow-Origin: ").append(allowOrigin).append("\r\n");
     }
+    if (config_.allowCredentials) 
+    {
+        common.append("Access-Control-Allow-Credentials: true\r\n");
+    }
+    if (varyOrigin)
+    {
+        common.append("Vary: Origin\r\n");
+    }
+
+    OriginHeaders headers;
+    headers.simple = common;
+    headers.preflight = common;
+    if (!config_.allowedMethods.empty()) 
+    {
+        headers.preflight.append("Access-Control-Allow-Methods: ")
+                         .append(join(config_.allowedMethods, ", ")).append("\r\n");
+    }
+    if (!config_.allowedHeaders.empty()) 
+    {
+        headers.preflight.append("Access-Control-Allow-Headers: ")
+                         .append(join(config_.allowedHeaders, ", ")).append("\r\n");
+    }
+    // 浏览器在 Max-Age 内复用预检结果，同一个接口不再重复发 OPTIONS
+    if (config_.maxAge > 0)
+    {
+        headers.preflight.append("Access-Control-Max-Age: ")
+                         .append(std::to_string(config_.maxAge)).append("\r\n");
+    }
+    return headers;
 }
 
-void CorsMiddleware::after(HttpResponse& response) 
+const CorsMiddleware::OriginHeaders* CorsMiddleware::lookup(std::string_view origin, bool* reflect) const
 {
-    LOG_DEBUG << "CorsMiddleware::after - Processing response";
-    
-    // 直接添加CORS头，简化处理逻辑
-    if (!config_.allowedOrigins.empty()) 
+    *reflect = false;
+    if (anyOrigin_)
     {
-        // 如果允许所有源
-        if (std::find(config_.allowedOrigins.begin(), config_.allowedOrigins.end(), "*") 
-            != config_.allowedOrigins.end()) 
-        {
-            addCorsHeaders(response, "*");
-        } 
-        else 
-        {
-            // 添加第一个允许的源
-            addCorsHeaders(response, config_.allowedOrigins[0]);
-        }
+        *reflect = reflectAnyOrigin_ && !origin.empty();
+        return anyOrigin_.get();
     }
+    auto it = originIndex_.find(origin);
+    return it != originIndex_.end() ? &it->second : nullptr;
 }
 
-bool CorsMiddleware::isOriginAllowed(const std::string& origin) const 
+MiddlewareResult CorsMiddleware::before(HttpRequest& request, HttpResponse& response) 
 {
-    return config_.allowedOrigins.empty() || 
-           std::find(config_.allowedOrigins.begin(), 
-                    config_.allowedOrigins.end(), "*") != config_.allowedOrigins.end() ||
-           std::find(config_.allowedOrigins.begin(), 
-                    config_.allowedOrigins.end(), origin) != config_.allowedOrigins.end();
+    if (request.method() == HttpRequest::Method::kOptions)  //预检请求，直接返回允许response
+    {
+        handlePreflightRequest(request, response);
+        return MiddlewareResult::kRespond;
+    }
+    return MiddlewareResult::kContinue;
 }
 
-void CorsMiddleware::handlePreflightRequest(const HttpRequest& request, 
-                                          HttpResponse& response) 
+void CorsMiddleware::after(const HttpRequest& request, HttpResponse& response) 
 {
-    const std::string& origin = request.getHeader("Origin");
-    
-    if (!isOriginAllowed(origin))  //看来源是否被允许
+    // 不带 Origin 的请求不是跨域请求，只有允许任意来源时照旧加上 "*"
+    std::string_view origin = request.getHeader(kHeaderOrigin);
+    bool reflect;
+    const OriginHeaders* headers = lookup(origin, &reflect);
+    if (!headers)
     {
-        LOG_WARN << "Origin not allowed: " << origin;
-        response.setStatusCode(HttpResponse::k403Forbidden);
         return;
     }
-
-    addCorsHeaders(response, origin);
-    response.setStatusCode(HttpResponse::k204NoContent);
-    LOG_INFO << "Preflight request processed successfully";
+    if (reflect)
+    {
+        response.addHeader("Access-Control-Allow-Origin", std::string(origin));
+    }
+    response.setHeaderBlock(&headers->simple);
 }
 
-void CorsMiddleware::addCorsHeaders(HttpResponse& response, 
-                                  const std::string& origin) 
+void CorsMiddleware::handlePreflightRequest(const HttpRequest& request, 
+                                          HttpResponse& response) 
 {
-    try 
+    std::string_view origin = request.getHeader(kHeaderOrigin);
+    bool reflect;
+    const OriginHeaders* headers = lookup(origin, &reflect);
+    if (!headers)  //看来源是否被允许
     {
-        response.addHeader("Access-Control-Allow-Origin", origin);
-        
-        if (config_.allowCredentials) 
-        {
-            response.addHeader("Access-Control-Allow-Credentials", "true");
-        }
-        
-        if (!config_.allowedMethods.empty()) 
-        {
-            response.addHeader("Access-Control-Allow-Methods", 
-                             join(config_.allowedMethods, ", "));
-        }
-        
-        if (!config_.allowedHeaders.empty()) 
-        {
-            response.addHeader("Access-Control-Allow-Headers", 
-                             join(config_.allowedHeaders, ", "));
-        }
-        
-        response.addHeader("Access-Control-Max-Age", 
-                          std::to_string(config_.maxAge));
-        
-        LOG_DEBUG << "CORS headers added successfully";
-    } 
-    catch (const std::exception& e) 
+        LOG_WARN << "Origin not allowed: " << std::string(origin);
+        response.setStatusLine(request.getVersion(), HttpResponse::k403Forbidden, "Forbidden");
+        response.setContentLength(0);
+        return;
+    }
+
+    if (reflect)
     {
-        LOG_ERROR << "Error adding CORS headers: " << e.what();
+        response.addHeader("Access-Control-Allow-Origin", std::string(origin));
     }
+    response.setHeaderBlock(&headers->preflight);
+    // 204 没有响应体，连接可以继续复用
+    response.setStatusLine(request.getVersion(), HttpResponse::k204NoContent, "No Content");
+    LOG_DEBUG << "Preflight request processed successfully";
 }
 
 // 工具函数：将字符串数组连接成单个字符串
@@ -119,4 +148,4 @@ std::string CorsMiddleware::join(const std::vector<std::string>& strings, const
 }
 
 } // namespace middleware
-} // namespace http
\ No newline at end of file
+} // namespace http
@@ -0,0 +1,209 @@
+#include "../../include/router/RadixTree.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace http
+{
+namespace router
+{
+
+struct RadixTree::Node
+{
+    std::string                        prefix; // 进入这个静态节点要匹配的文本，参数和通配节点为空
+    std::string                        indices; // 各静态子节点前缀的首字节，与 children 一一对应
+    std::vector<std::unique_ptr<Node>> children; // 静态子节点，首字节互不相同
+    std::unique_ptr<Node>              param; // ":name" 子节点
+    std::unique_ptr<Node>              wildcard; // "*name" 子节点，没有后代
+    int                                id = -1; // 在这里结束的路由编号
+    std::vector<std::string>           paramNames; // 在这里结束的路由的参数名
+};
+
+RadixTree::RadixTree()
+    : root_(new Node)
+{
+}
+
+RadixTree::~RadixTree() = default;
+
+int RadixTree::insert(std::string_view pattern, int id, std::vector<std::string>* paramNames)
+{
+    if (pattern.empty() || pattern[0] != '/')
+    {
+        throw std::invalid_argument("route pattern must start with '/': " + std::string(pattern));
+    }
+
+    paramNames->clear();
+    Node* node = root_.get();
+    size_t pos = 0;
+    while (pos < pattern.size())
+    {
+        char c = pattern[pos];
+        if (c == ':' || c == '*')
+        {
+            // 参数到下一个 '/' 为止，通配一直到模式结尾
+            size_t end = (c == ':') ? pattern.find('/', pos) : pattern.size();
+            if (end == std::string_view::npos)
+            {
+                end = pattern.size();
+            }
+            std::string_view name = pattern.substr(pos + 1, end - pos - 1);
+            if (name.empty() || name.find_first_of(":*/") != std::string_view::npos)
+            {
+                throw std::invalid_argument("malformed parameter in route pattern: " + std::string(pattern));
+            }
+            if (paramNames->size() == static_cast<size_t>(HttpRequest::kMaxPathParameters))
+            {
+                throw std::invalid_argument("too many parameters in route pattern: " + std::string(pattern));
+            }
+            paramNames->emplace_back(name);
+
+            std::unique_ptr<Node>& child = (c == ':') ? node->param : node->wildcard;
+            if (!child)
+            {
+                child.reset(new Node);
+            }
+            node = child.get();
+            pos = end;
+        }
+        else
+        {
+            size_t end = pattern.find_first_of(":*", pos);
+            if (end == std::string_view::npos)
+            {
+                end = pattern.size();
+            }
+            node = insertStatic(node, pattern.substr(pos, end - pos));
+            pos = end;
+        }
+    }
+
+    if (node->id < 0)
+    {
+        node->id = id;
+        node->paramNames = *paramNames;
+    }
+    else if (node->paramNames != *paramNames)
+    {
+        // 形状相同的模式匹配的是同一组路径，参数名不同时后注册的处理器读不到自己的参数
+        throw std::invalid_argument("route pattern " + std::string(pattern)
+                                    + " conflicts with an existing route that names its parameters differently");
+    }
+    return node->id;
+}
+
+// 把一段静态文本挂到 node 下面，必要时把已有节点从公共前缀处拆成两段，返回文本结束处的节点
+RadixTree::Node* RadixTree::insertStatic(Node* node, std::string_view text)
+{
+    while (!text.empty())
+    {
+        size_t i = node->indices.find(text[0]);
+        if (i == std::string::npos)
+        {
+            std::unique_ptr<Node> child(new Node);
+            child->prefix.assign(text.data(), text.size());
+            node->indices.push_back(text[0]);
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+
+        Node* child = node->children[i].get();
+        size_t common = 0;
+        size_t limit = std::min(child->prefix.size(), text.size());
+        while (common < limit && child->prefix[common] == text[common])
+        {
+            ++common;
+        }
+
+        if (common < child->prefix.size())
+        {
+            // 拆分：新节点持有公共前缀，原节点保留剩余部分并成为它唯一的子节点
+            std::unique_ptr<Node> split(new Node);
+            split->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            split->indices.push_back(child->prefix[0]);
+            split->children.push_back(std::move(node->children[i]));
+            node->children[i] = std::move(split);
+            child = node->children[i].get();
+        }
+        node = child;
+        text.remove_prefix(common);
+    }
+    return node;
+}
+
+int RadixTree::match(std::string_view path, PathCaptures* captures) const
+{
+    if (captures)
+    {
+        captures->count = 0;
+    }
+    return matchNode(root_.get(), path, captures);
+}
+
+// node 的前缀已经匹配掉，path 是剩余部分
+int RadixTree::matchNode(const Node* node, std::string_view path, PathCaptures* captures)
+{
+    if (path.empty())
+    {
+        if (node->id >= 0)
+        {
+            return node->id;
+        }
+    }
+    else
+    {
+        size_t i = node->indices.find(path[0]);
+        if (i != std::string::npos)
+        {
+            const Node* child = node->children[i].get();
+            if (path.compare(0, child->prefix.size(), child->prefix) == 0)
+            {
+                int id = matchNode(child, path.substr(child->prefix.size()), captures);
+                if (id >= 0)
+                {
+                    return id;
+                }
+            }
+        }
+
+        if (node->param)
+        {
+            size_t end = path.find('/');
+            if (end == std::string_view::npos)
+            {
+                end = path.size();
+            }
+            if (end > 0)
+            {
+                int saved = captures ? captures->count : 0;
+                if (captures)
+                {
+                    captures->values[captures->count++] = path.substr(0, end);
+                }
+                int id = matchNode(node->param.get(), path.substr(end), captures);
+                if (id >= 0)
+                {
+                    return id;
+                }
+                if (captures)
+                {
+                    captures->count = saved;
+                }
+            }
+        }
+    }
+
+    if (node->wildcard && node->wildcard->id >= 0)
+    {
+        if (captures)
+        {
+            captures->values[captures->count++] = path;
+        }
+        return node->wildcard->id;
+    }
+    return -1;
+}
+
+} // namespace router
+} // namespace http
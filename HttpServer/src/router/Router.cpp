@@ -1,4 +1,5 @@
 #include "../../include/router/Router.h"
+#include "../../include/metrics/Metrics.h"
 #include <muduo/base/Logging.h>
 
 namespace http
@@ -6,74 +7,88 @@ namespace http
 namespace router
 {
 
-void Router::registerHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler)
+Route &Router::addRoute(HttpRequest::Method method, const std::string &path)
 {
-    RouteKey key{method, path};
-    handlers_[key] = std::move(handler);
+    std::vector<std::string> paramNames;
+    int next = static_cast<int>(routes_.size());
+    int id = trees_[method].insert(path, next, &paramNames);
+    if (id == next)
+    {
+        routes_.emplace_back();
+        routes_.back().pattern = path;
+        routes_.back().paramNames = std::move(paramNames);
+    }
+    return routes_[id];
 }
 
-void Router::registerCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback)
+void Router::registerHandler(HttpRequest::Method method, const std::string &path, HandlerPtr handler,
+                             bool blocking, const BodyDataCallback &onBody)
 {
-    RouteKey key{method, path};
-    callbacks_[key] = std::move(callback);
+    Route &route = addRoute(method, path);
+    route.handler = std::move(handler);
+    route.blocking = route.blocking || blocking;
+    if (onBody)
+    {
+        route.onBody = onBody;
+    }
 }
 
-bool Router::route(const HttpRequest &req, HttpResponse *resp)
+void Router::registerCallback(HttpRequest::Method method, const std::string &path, const HandlerCallback &callback,
+                              bool blocking, const BodyDataCallback &onBody)
 {
-    RouteKey key{req.method(), req.path()};
-
-    // 查找处理器
-    auto handlerIt = handlers_.find(key);
-    if (handlerIt != handlers_.end())
+    Route &route = addRoute(method, path);
+    route.callback = callback;
+    route.blocking = route.blocking || blocking;
+    if (onBody)
     {
-        handlerIt->second->handle(req, resp);
-        return true;
+        route.onBody = onBody;
     }
+}
 
-    // 查找回调函数
-    auto callbackIt = callbacks_.find(key);
-    if (callbackIt != callbacks_.end())
+const Route *Router::match(HttpRequest &req) const
+{
+    // 一次遍历同时完成静态和带参数路由的匹配，参数值只是指向请求路径的片段
+    PathCaptures captures;
+    int id = trees_[req.method()].match(req.path(), &captures);
+    req.clearPathParameters();
+    if (id < 0)
     {
-        callbackIt->second(req, resp);
-        return true;
+        return nullptr;
     }
 
-    // 查找动态路由处理器
-    for (const auto &[method, pathRegex, handler] : regexHandlers_)
+    const Route &route = routes_[id];
+    for (int i = 0; i < captures.count; ++i)
     {
-        std::smatch match; //是 C++ 标准库中为 std::string 专门定义的一种“匹配结果”容器类型
-        std::string pathStr(req.path());
-        // 如果方法匹配并且动态路由匹配，则执行处理器
-        if (method == req.method() && std::regex_match(pathStr, match, pathRegex)) //查看是否匹配形式并用match捕获
-        {
-            // Extract path parameters and add them to the request
-            HttpRequest newReq(req); // 因为这里需要额外添加参数，所以新建一个
-            extractPathParameters(match, newReq);   
-            
-            handler->handle(newReq, resp);
-            return true;
-        }
+        req.addPathParameter(route.paramNames[i], captures.values[i]);
     }
+    return &route;
+}
 
-    // 查找动态路由回调函数
-    for (const auto &[method, pathRegex, callback] : regexCallbacks_)
+void Router::dispatch(const Route &route, HttpRequest &req, HttpResponse *resp) const
+{
+    // 路由表在服务启动后不再修改，标签直接引用表中的路径模式
+    metrics::RequestTrace::current().setRoute(req.method(), &route.pattern);
+    metrics::StageTimer timer(metrics::kHandler);
+    if (route.handler)
     {
-        std::smatch match;
-        std::string pathStr(req.path());
-        // 如果方法匹配并且动态路由匹配，则执行回调函数
-        if (method == req.method() && std::regex_match(pathStr, match, pathRegex))
-        {
-             // Extract path parameters and add them to the request
-            HttpRequest newReq(req); // 因为这里需要用这一次所以是可以改的
-            extractPathParameters(match, newReq); //实际是填充路劲参数
-
-            callback(req, resp);
-            return true;
-        }
+        route.handler->handle(req, resp);
+    }
+    else
+    {
+        route.callback(req, resp);
     }
+}
 
-    return false;
+bool Router::route(HttpRequest &req, HttpResponse *resp) const
+{
+    const Route *route = match(req);
+    if (!route)
+    {
+        return false;
+    }
+    dispatch(*route, req, resp);
+    return true;
 }
 
 } // namespace router
-} // namespace http
\ No newline at end of file
+} // namespace http
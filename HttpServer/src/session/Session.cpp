@@ -18,29 +18,37 @@ Session::Session(const std::string& sessionId, SessionManager* sessionManager, i
 // 检查会话是否已过期
 bool Session::isExpired() const
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     return std::chrono::system_clock::now() > expiryTime_;
 }
 
 // 刷新会话的过期时间
 void Session::refresh()
 {
-    expiryTime_ = std::chrono::system_clock::now() + std::chrono::seconds(maxAge_); //绝对时间
+    auto expiry = std::chrono::system_clock::now() + std::chrono::seconds(maxAge_); //绝对时间
+    std::lock_guard<std::mutex> lock(mutex_);
+    expiryTime_ = expiry;
 }
 
 // 设置会话数据
 void Session::setValue(const std::string& key, const std::string& value)
 {
-    data_[key] = value;
-    // 如果设置了manager，自动保存更改
-    if (sessionManager_)
     {
-        sessionManager_->updateSession(shared_from_this());
+        std::lock_guard<std::mutex> lock(mutex_);
+        data_[key] = value;
+    }
+    // 如果设置了manager，自动保存更改；保存时不持有会话的锁，存储自己加锁
+    SessionManager* manager = getManager();
+    if (manager)
+    {
+        manager->updateSession(shared_from_this());
     }
 }
 
 // 获取会话数据
 std::string Session::getValue(const std::string& key) const
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     auto it = data_.find(key);
     return it != data_.end() ? it->second : std::string();
 }
@@ -48,12 +56,14 @@ std::string Session::getValue(const std::string& key) const
 // 删除会话数据
 void Session::remove(const std::string& key)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     data_.erase(key);
 }
 
 // 清空会话数据
 void Session::clear()
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     data_.clear();
 }
 
@@ -49,6 +49,7 @@ std::string SessionManager::generateSessionId()
     std::uniform_int_distribution<> dist(0, 15);
 
     // 生成32个字符的会话ID，每个字符是一个十六进制数字
+    std::lock_guard<std::mutex> lock(rngMutex_);
     for (int i = 0; i < 32; ++i)
     {
         ss << std::hex << dist(rng_);
@@ -71,23 +72,17 @@ void SessionManager::cleanExpiredSessions()
 std::string SessionManager::getSessionIdFromCookie(const HttpRequest& req)
 {
     std::string sessionId;
-    std::string cookie = req.getHeader("Cookie");
+    std::string_view cookie = req.getHeader(kHeaderCookie);
 
     if (!cookie.empty())
     {
         size_t pos = cookie.find("sessionId=");
-        if (pos != std::string::npos)
+        if (pos != std::string_view::npos)
         {
             pos += 10; // 跳过"sessionId="
             size_t end = cookie.find(';', pos);
-            if (end != std::string::npos)
-            {
-                sessionId = cookie.substr(pos, end - pos);
-            }
-            else
-            {
-                sessionId = cookie.substr(pos);
-            }
+            // 只拷贝会话 ID 本身
+            sessionId.assign(cookie.substr(pos, end == std::string_view::npos ? end : end - pos));
         }
     }
     
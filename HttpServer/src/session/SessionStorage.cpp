@@ -9,6 +9,7 @@ namespace session
 
 void MemorySessionStorage::save(std::shared_ptr<Session> session)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     // 创建会话副本并存储
     sessions_[session->getId()] = session;
 }
@@ -16,6 +17,7 @@ void MemorySessionStorage::save(std::shared_ptr<Session> session)
 // 通过会话ID从存储中加载会话
 std::shared_ptr<Session> MemorySessionStorage::load(const std::string& sessionId)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     auto it = sessions_.find(sessionId);
     if (it != sessions_.end())
     {
@@ -37,6 +39,7 @@ std::shared_ptr<Session> MemorySessionStorage::load(const std::string& sessionId
 // 通过会话ID从存储中移除会话
 void MemorySessionStorage::remove(const std::string& sessionId)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     sessions_.erase(sessionId);
 }
 
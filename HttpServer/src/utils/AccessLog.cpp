@@ -0,0 +1,255 @@
+#include "../../include/utils/AccessLog.h"
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace http
+{
+
+namespace
+{
+
+const char* methodName(int method)
+{
+    switch (method)
+    {
+        case HttpRequest::kGet:     return "GET";
+        case HttpRequest::kPost:    return "POST";
+        case HttpRequest::kHead:    return "HEAD";
+        case HttpRequest::kPut:     return "PUT";
+        case HttpRequest::kDelete:  return "DELETE";
+        case HttpRequest::kOptions: return "OPTIONS";
+        default:                    return "-";
+    }
+}
+
+std::atomic<uint64_t> g_nextInstanceId{1};
+
+// 路径是客户端给的原始字节：引号、反斜杠和不可打印字节（控制字符、终端转义序列）写成 \xHH，
+// 避免伪造或截断日志行。dst 至少要有 len * 4 + 1 字节，返回写入的长度
+size_t escapePath(const char* src, size_t len, char* dst)
+{
+    static const char kHexDigits[] = "0123456789abcdef";
+    char* p = dst;
+    for (size_t i = 0; i < len; ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(src[i]);
+        if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\')
+        {
+            *p++ = static_cast<char>(c);
+        }
+        else
+        {
+            *p++ = '\\';
+            *p++ = 'x';
+            *p++ = kHexDigits[c >> 4];
+            *p++ = kHexDigits[c & 0xf];
+        }
+    }
+    *p = '\0';
+    return p - dst;
+}
+
+// 每行格式：对端地址 [时间] "方法 路径" 状态码 字节数 耗时(us)
+int formatRecord(const AccessLogRecord& rec, char* buf, size_t size)
+{
+    char peer[INET6_ADDRSTRLEN] = "-";
+    if (rec.peer.sin6_family == AF_INET)
+    {
+        const struct sockaddr_in* addr4 = reinterpret_cast<const struct sockaddr_in*>(&rec.peer);
+        ::inet_ntop(AF_INET, &addr4->sin_addr, peer, sizeof peer);
+    }
+    else if (rec.peer.sin6_family == AF_INET6)
+    {
+        ::inet_ntop(AF_INET6, &rec.peer.sin6_addr, peer, sizeof peer);
+    }
+
+    time_t seconds = static_cast<time_t>(rec.receiveTimeUs / 1000000);
+    struct tm tm;
+    ::gmtime_r(&seconds, &tm);
+    char when[32];
+    ::strftime(when, sizeof when, "%Y-%m-%dT%H:%M:%S", &tm);
+
+    char path[sizeof rec.path * 4 + 1];
+    escapePath(rec.path, rec.pathLen, path);
+
+    return snprintf(buf, size, "%s [%s.%06dZ] \"%s %s\" %u %u %u\n",
+                    peer, when, static_cast<int>(rec.receiveTimeUs % 1000000),
+                    methodName(rec.method), path,
+                    rec.status, rec.bytes, rec.latencyUs);
+}
+
+} // namespace
+
+struct AccessLog::Ring
+{
+    static const size_t kCapacity = 1024; // 必须是 2 的幂
+
+    // 生产者只写 head，消费者只写 tail，分开放在不同的缓存行上
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    AccessLogRecord                 records[kCapacity];
+
+    bool push(const AccessLogRecord& rec)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= kCapacity)
+        {
+            return false;
+        }
+        records[h & (kCapacity - 1)] = rec;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(AccessLogRecord* rec)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        *rec = records[t & (kCapacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+AccessLog::AccessLog(const std::string& basename, off_t rollSize, int sampleEvery)
+    : sampleEvery_(sampleEvery > 0 ? sampleEvery : 1)
+    , instanceId_(g_nextInstanceId.fetch_add(1, std::memory_order_relaxed))
+    , output_(basename, rollSize)
+    , running_(false)
+    , dropped_(0)
+{}
+
+AccessLog::~AccessLog()
+{
+    stop();
+}
+
+void AccessLog::start()
+{
+    running_ = true;
+    output_.start();
+    writer_ = std::thread(&AccessLog::writerThread, this);
+}
+
+void AccessLog::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    cond_.notify_one();
+    writer_.join();
+    output_.stop();
+}
+
+AccessLog::Ring* AccessLog::threadRing()
+{
+    // 一个进程里通常只有一个 AccessLog；换了实例就重新注册。按实例编号而不是地址识别，
+    // 新实例可能分配在已销毁实例的地址上，那时缓存的 t_ring 已经随旧实例释放了
+    thread_local uint64_t t_ownerId = 0;
+    thread_local Ring* t_ring = nullptr;
+    if (t_ownerId != instanceId_)
+    {
+        auto ring = std::make_shared<Ring>();
+        t_ring = ring.get();
+        t_ownerId = instanceId_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.push_back(std::move(ring));
+    }
+    return t_ring;
+}
+
+void AccessLog::log(const muduo::net::TcpConnectionPtr& conn, const HttpRequest& req,
+                    int status, size_t bytes)
+{
+    // 采样判断放在最前面，不记录的请求没有任何额外开销
+    thread_local unsigned t_counter = 0;
+    if (++t_counter % sampleEvery_ != 0 && status < 500)
+    {
+        return;
+    }
+
+    AccessLogRecord rec;
+    int64_t receiveUs = req.receiveTime().microSecondsSinceEpoch();
+    int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    rec.receiveTimeUs = receiveUs;
+    rec.latencyUs = static_cast<uint32_t>(nowUs > receiveUs ? nowUs - receiveUs : 0);
+    rec.bytes = static_cast<uint32_t>(bytes);
+    rec.status = static_cast<uint16_t>(status);
+    rec.method = static_cast<uint8_t>(req.method());
+    ::memcpy(&rec.peer, conn->peerAddress().getSockAddr(), sizeof rec.peer);
+    std::string_view path = req.path();
+    rec.pathLen = static_cast<uint8_t>(std::min(path.size(), sizeof rec.path));
+    ::memcpy(rec.path, path.data(), rec.pathLen);
+
+    if (!threadRing()->push(rec))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AccessLog::writerThread()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait_for(lock, std::chrono::milliseconds(200), [this] { return !running_; });
+            if (!running_)
+            {
+                break;
+            }
+        }
+        drain();
+    }
+    drain();
+}
+
+void AccessLog::drain()
+{
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings = rings_;
+    }
+
+    // 攒成一大块再交给 AsyncLogging，减少它内部加锁的次数
+    static const size_t kChunk = 64 * 1024;
+    std::string chunk;
+    chunk.reserve(kChunk);
+    char line[sizeof(AccessLogRecord::path) * 4 + 160];
+    AccessLogRecord rec;
+    for (const auto& ring : rings)
+    {
+        while (ring->pop(&rec))
+        {
+            int n = formatRecord(rec, line, sizeof line);
+            chunk.append(line, std::min(static_cast<size_t>(n), sizeof line - 1));
+            if (chunk.size() >= kChunk - sizeof line)
+            {
+                output_.append(chunk.data(), static_cast<int>(chunk.size()));
+                chunk.clear();
+            }
+        }
+    }
+    if (!chunk.empty())
+    {
+        output_.append(chunk.data(), static_cast<int>(chunk.size()));
+    }
+}
+
+} // namespace http
@@ -0,0 +1,85 @@
+#include "../../include/utils/FileCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+CachedFile::~CachedFile()
+{
+    ::close(fd_);
+}
+
+bool CachedFile::readInto(muduo::net::Buffer* buf) const
+{
+    buf->ensureWritableBytes(size_);
+    size_t done = 0;
+    while (done < size_)
+    {
+        ssize_t n = ::pread(fd_, buf->beginWrite(), size_ - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            LOG_SYSERR << "CachedFile::readInto pread failed";
+            return false;
+        }
+        buf->hasWritten(n);
+        done += n;
+    }
+    return true;
+}
+
+CachedFilePtr FileCache::open(const std::string& path)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0 || !S_ISREG(st.st_mode))
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        files_.erase(path);
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(path);
+        if (it != files_.end() &&
+            it->second->mtime() == st.st_mtime &&
+            it->second->size() == static_cast<size_t>(st.st_size))
+        {
+            return it->second;
+        }
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "FileCache: open " << path << " failed";
+        return nullptr;
+    }
+    // 以打开后的 fd 为准，避免 stat 和 open 之间文件被替换
+    if (::fstat(fd, &st) < 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto file = std::make_shared<const CachedFile>(fd, static_cast<size_t>(st.st_size), st.st_mtime);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (files_.size() >= kMaxFiles)
+    {
+        // 正在发送的文件由各自的 shared_ptr 持有，清空缓存不会影响它们
+        files_.clear();
+    }
+    files_[path] = file;
+    return file;
+}
+
+} // namespace http
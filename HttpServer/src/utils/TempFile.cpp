@@ -0,0 +1,74 @@
+#include "../../include/utils/TempFile.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <muduo/base/Logging.h>
+
+namespace http
+{
+
+std::shared_ptr<TempFile> TempFile::create(const std::string& dir)
+{
+    std::string path = dir + "/http-body-XXXXXX";
+    int fd = ::mkostemp(&path[0], O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "TempFile: mkostemp in " << dir << " failed";
+        return nullptr;
+    }
+    return std::shared_ptr<TempFile>(new TempFile(fd, path));
+}
+
+TempFile::~TempFile()
+{
+    ::close(fd_);
+    ::unlink(path_.c_str());
+}
+
+bool TempFile::append(const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::write(fd_, data, len);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            LOG_SYSERR << "TempFile: write " << path_ << " failed";
+            return false;
+        }
+        data += n;
+        len -= n;
+        size_ += n;
+    }
+    return true;
+}
+
+bool TempFile::readAll(std::string* out) const
+{
+    out->resize(size_);
+    size_t done = 0;
+    while (done < size_)
+    {
+        ssize_t n = ::pread(fd_, &(*out)[done], size_ - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            LOG_SYSERR << "TempFile: read " << path_ << " failed";
+            out->resize(done);
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+} // namespace http
@@ -58,6 +58,12 @@ public:
         return winner_; 
     }
 
+    // 回合锁：持有期间完成一次落子和随后的状态读取，同一局的并发请求依次执行
+    std::mutex& turnMutex()
+    {
+        return turnMutex_;
+    }
+
 private:
     // 检查移动是否有效
     bool isValidMove(int x, int y) const 
@@ -89,4 +95,5 @@ private:
     std::pair<int, int>                   lastMove_{-1, -1};  // 上一次落子位置
     std::vector<std::vector<std::string>> board_;
     mutable std::mutex                    mutex_;  // 添加互斥锁
+    std::mutex                            turnMutex_; // 回合锁，见 turnMutex()
 };
\ No newline at end of file
@@ -36,6 +36,11 @@ public:
                  muduo::net::TcpServer::Option option = muduo::net::TcpServer::kNoReusePort);
 
     void setThreadNum(int numThreads);
+    void setWorkerThreadNum(int numThreads);
+    void enableShardedListen(bool enable);
+    void enableAccessLog(const std::string& basename, int sampleEvery);
+    void enableGracefulShutdown(double drainSeconds);
+    void enableHandoff(const std::string& path);
     void start();
 private:
     void initialize();
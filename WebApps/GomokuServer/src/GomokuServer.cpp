@@ -17,7 +17,7 @@ using namespace http;
 GomokuServer::GomokuServer(int port,
                            const std::string &name,
                            muduo::net::TcpServer::Option option)
-    : httpServer_(port, name, option), maxOnline_(0)
+    : httpServer_(port, name, false, option), maxOnline_(0)
 {
     initialize();
 }
@@ -27,6 +27,31 @@ void GomokuServer::setThreadNum(int numThreads)
     httpServer_.setThreadNum(numThreads);
 }
 
+void GomokuServer::setWorkerThreadNum(int numThreads)
+{
+    httpServer_.setWorkerThreadNum(numThreads);
+}
+
+void GomokuServer::enableShardedListen(bool enable)
+{
+    httpServer_.enableShardedListen(enable);
+}
+
+void GomokuServer::enableAccessLog(const std::string& basename, int sampleEvery)
+{
+    httpServer_.enableAccessLog(basename, sampleEvery);
+}
+
+void GomokuServer::enableGracefulShutdown(double drainSeconds)
+{
+    httpServer_.enableGracefulShutdown(drainSeconds);
+}
+
+void GomokuServer::enableHandoff(const std::string& path)
+{
+    httpServer_.enableHandoff(path);
+}
+
 void GomokuServer::start()
 {
     httpServer_.start();
@@ -56,11 +81,8 @@ void GomokuServer::initializeSession()
 
 void GomokuServer::initializeMiddleware()
 {
-    // 创建中间件
-    auto corsMiddleware = std::make_shared<http::middleware::CorsMiddleware>();
-    
-    // 添加中间件
-    httpServer_.addMiddleware(corsMiddleware);
+    // 中间件在启动时就固定了，组合成静态链
+    httpServer_.addMiddlewares(http::middleware::CorsMiddleware());
 }
 
 void GomokuServer::initializeRouter()
@@ -69,10 +91,11 @@ void GomokuServer::initializeRouter()
     // 登录注册入口页面
     httpServer_.Get("/", std::make_shared<EntryHandler>(this));
     httpServer_.Get("/entry", std::make_shared<EntryHandler>(this));
+    // 登录、注册、下棋和后台数据都会阻塞（MySQL 查询 / AI 计算），放到工作线程池中执行
     // 登录
-    httpServer_.Post("/login", std::make_shared<LoginHandler>(this));
+    httpServer_.PostAsync("/login", std::make_shared<LoginHandler>(this));
     // 注册
-    httpServer_.Post("/register", std::make_shared<RegisterHandler>(this));
+    httpServer_.PostAsync("/register", std::make_shared<RegisterHandler>(this));
     // 登出
     httpServer_.Post("/user/logout", std::make_shared<LogoutHandler>(this));
     // 菜单页面
@@ -80,7 +103,7 @@ void GomokuServer::initializeRouter()
     // 开始对战ai
     httpServer_.Get("/aiBot/start", std::make_shared<AiGameStartHandler>(this));
     // 下棋
-    httpServer_.Post("/aiBot/move", std::make_shared<AiGameMoveHandler>(this));
+    httpServer_.PostAsync("/aiBot/move", std::make_shared<AiGameMoveHandler>(this));
     // 重新开始对战ai
     httpServer_.Get("/aiBot/restart", 
     [this](const http::HttpRequest& req, http::HttpResponse* resp) {
@@ -90,9 +113,11 @@ void GomokuServer::initializeRouter()
     // 后台界面
     httpServer_.Get("/backend", std::make_shared<GameBackendHandler>(this));
     // 后台数据获取
-    httpServer_.Get("/backend_data", [this](const http::HttpRequest& req, http::HttpResponse* resp) {
+    httpServer_.GetAsync("/backend_data", [this](const http::HttpRequest& req, http::HttpResponse* resp) {
         getBackendData(req, resp);
     });
+    // 各阶段耗时分位数（Prometheus 格式）
+    httpServer_.enableMetrics("/metrics");
     
     // 用于验证缓存是否命中的测试接口：GET /__cache_test
     httpServer_.Get("/__cache_test",
@@ -25,13 +25,29 @@ void AiGameMoveHandler::handle(const http::HttpRequest &req, http::HttpResponse
         int x = request["x"];
         int y = request["y"];
 
-        // 获取或创建游戏实例
-        if (server_->aiGames_.find(userId) == server_->aiGames_.end())
+        // 获取或创建游戏实例：这个路由在工作线程池中执行，查找和创建都要持锁；
+        // 拷出 shared_ptr 而不是引用表里的元素，其它请求删除或重建这一局后它仍然有效
+        std::shared_ptr<AiGame> game;
         {
             std::lock_guard<std::mutex> lock(server_->mutexForAiGames_);
-            server_->aiGames_[userId] = std::make_shared<AiGame>(userId);
+            auto &slot = server_->aiGames_[userId];
+            if (!slot)
+            {
+                slot = std::make_shared<AiGame>(userId);
+            }
+            game = slot;
         }
-        auto &game = server_->aiGames_[userId];
+        // 同一局的落子请求可能同时在多个工作线程上执行，一次完整的回合（人类一步 + AI 一步）按顺序进行
+        std::lock_guard<std::mutex> turnLock(game->turnMutex());
+        // 游戏结束后删掉这一局，之后每次 restart 重新创建；期间已经被重新开局的不删
+        auto finishGame = [this, userId, &game] {
+            std::lock_guard<std::mutex> lock(server_->mutexForAiGames_);
+            auto it = server_->aiGames_.find(userId);
+            if (it != server_->aiGames_.end() && it->second == game)
+            {
+                server_->aiGames_.erase(it);
+            }
+        };
 
         // 处理人类玩家移动
         if (!game->humanMove(x, y))
@@ -65,10 +81,7 @@ void AiGameMoveHandler::handle(const http::HttpRequest &req, http::HttpResponse
             resp->setContentLength(responseBody.size());
             resp->setBody(responseBody);
 
-            {
-                std::lock_guard<std::mutex> lock(server_->mutexForAiGames_);
-                server_->aiGames_.erase(userId); // 这里删掉以后，每次restart都需要重新创建就行
-            }
+            finishGame();
             return;
         }
 
@@ -88,10 +101,7 @@ void AiGameMoveHandler::handle(const http::HttpRequest &req, http::HttpResponse
             resp->setContentLength(responseBody.size());
             resp->setBody(responseBody);
 
-            {
-                std::lock_guard<std::mutex> lock(server_->mutexForAiGames_);
-                server_->aiGames_.erase(userId); // 这里删掉以后，每次restart都需要重新创建就行
-            }
+            finishGame();
             return;
         }
 
@@ -115,10 +125,7 @@ void AiGameMoveHandler::handle(const http::HttpRequest &req, http::HttpResponse
             resp->setContentLength(responseBody.size());
             resp->setBody(responseBody);
 
-            {
-                std::lock_guard<std::mutex> lock(server_->mutexForAiGames_);
-                server_->aiGames_.erase(userId); // 这里删掉以后，每次restart都需要重新创建就行
-            }
+            finishGame();
             return;
         }
 
@@ -139,10 +146,7 @@ void AiGameMoveHandler::handle(const http::HttpRequest &req, http::HttpResponse
             resp->setContentLength(responseBody.size());
             resp->setBody(responseBody);
 
-            {
-                std::lock_guard<std::mutex> lock(server_->mutexForAiGames_);
-                server_->aiGames_.erase(userId); // 这里删掉以后，每次restart都需要重新创建就行
-            }
+            finishGame();
             return;
         }
 
@@ -29,20 +29,19 @@ void AiGameStartHandler::handle(const http::HttpRequest &req, http::HttpResponse
 
     // 创建一个ai机器人，它就while不断地执行下棋逻辑
     std::string reqFile("../WebApps/GomokuServer/resource/ChessGameVsAi.html");
-    FileUtil fileOperater(reqFile);
-    if (!fileOperater.isValid())
+    // 文件 fd 常驻缓存，响应体由服务器用 sendfile 直接从页缓存发送
+    http::CachedFilePtr file = http::FileCache::getInstance().open(reqFile);
+    if (!file)
     {
-        LOG_WARN << reqFile << "not exist.";
-        fileOperater.resetDefaultFile(); // FIXME:其实这里可能不必要，后续删了吧，不过其实也不会调用到毕竟详细地址是我服务端定义的
+        LOG_WARN << reqFile << " not exist";
+        resp->setStatusLine(req.getVersion(), http::HttpResponse::k404NotFound, "Not Found");
+        resp->setCloseConnection(false);
+        resp->setContentLength(0);
+        return;
     }
 
-    std::vector<char> buffer(fileOperater.size());
-    fileOperater.readFile(buffer);
-    std::string htmlContent(buffer.data(), buffer.size());
-
     resp->setStatusLine(req.getVersion(), http::HttpResponse::k200Ok, "OK");
     resp->setCloseConnection(false);
     resp->setContentType("text/html");
-    resp->setContentLength(htmlContent.size());
-    resp->setBody(htmlContent);
+    resp->setFileBody(file);
 }
@@ -3,22 +3,20 @@
 void EntryHandler::handle(const http::HttpRequest& req, http::HttpResponse* resp)
 {
     // 因为是get请求，请求的url也拿到了，我们就可以直接返回响应了
-    std::string reqFile;
-    reqFile.append("../WebApps/GomokuServer/resource/entry.html");
-    FileUtil fileOperater(reqFile);
-    if (!fileOperater.isValid())
+    std::string reqFile("../WebApps/GomokuServer/resource/entry.html");
+    // 文件 fd 常驻缓存，响应体由服务器用 sendfile 直接从页缓存发送
+    http::CachedFilePtr file = http::FileCache::getInstance().open(reqFile);
+    if (!file)
     {
         LOG_WARN << reqFile << " not exist";
-        fileOperater.resetDefaultFile(); // 404 NOT FOUND
+        resp->setStatusLine(req.getVersion(), http::HttpResponse::k404NotFound, "Not Found");
+        resp->setCloseConnection(false);
+        resp->setContentLength(0);
+        return;
     }
 
-    std::vector<char> buffer(fileOperater.size());
-    fileOperater.readFile(buffer); // 读出文件数据
-    std::string bufStr = std::string(buffer.data(), buffer.size());
-    
     resp->setStatusLine(req.getVersion(), http::HttpResponse::k200Ok, "OK");
     resp->setCloseConnection(false);
     resp->setContentType("text/html");
-    resp->setContentLength(bufStr.size());
-    resp->setBody(bufStr);
+    resp->setFileBody(file);
 }
@@ -5,20 +5,19 @@ void GameBackendHandler::handle(const http::HttpRequest& req, http::HttpResponse
     // 后台界面
     // 获取当前在线人数、历史最高在线人数、数据库中已注册用户总数
     std::string reqFile("../WebApps/GomokuServer/resource/Backend.html");
-    FileUtil fileOperater(reqFile);
-    if (!fileOperater.isValid())
+    // 文件 fd 常驻缓存，响应体由服务器用 sendfile 直接从页缓存发送
+    http::CachedFilePtr file = http::FileCache::getInstance().open(reqFile);
+    if (!file)
     {
-        LOG_WARN << reqFile << "not exist.";
-        fileOperater.resetDefaultFile();
+        LOG_WARN << reqFile << " not exist";
+        resp->setStatusLine(req.getVersion(), http::HttpResponse::k404NotFound, "Not Found");
+        resp->setCloseConnection(false);
+        resp->setContentLength(0);
+        return;
     }
 
-    std::vector<char> buffer(fileOperater.size());
-    fileOperater.readFile(buffer); // 读出文件数据
-    std::string htmlContent(buffer.data(), buffer.size());
-
     resp->setStatusLine(req.getVersion(), http::HttpResponse::k200Ok, "OK");
     resp->setCloseConnection(false);
     resp->setContentType("text/html");
-    resp->setContentLength(htmlContent.size());
-    resp->setBody(htmlContent);
+    resp->setFileBody(file);
 }
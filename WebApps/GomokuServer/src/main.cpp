@@ -12,9 +12,12 @@ int main(int argc, char* argv[])
   
   std::string serverName = "HttpServer";
   int port = 80;
+  bool sharded = false;
+  int accessLogSample = 0; // 0 表示不开启访问日志
+  std::string handoffPath; // 为空表示不做监听套接字交接
   // 参数解析
   int opt;
-  const char* str = "p:";
+  const char* str = "p:sa:H:";
   while ((opt = getopt(argc, argv, str)) != -1)
   {
     switch (opt)
@@ -24,6 +27,21 @@ int main(int argc, char* argv[])
         port = atoi(optarg);
         break;
       }
+      case 's': // 每个 IO 线程各自 SO_REUSEPORT 监听
+      {
+        sharded = true;
+        break;
+      }
+      case 'a': // 访问日志采样：每 N 个请求记录一条
+      {
+        accessLogSample = atoi(optarg);
+        break;
+      }
+      case 'H': // 不停机重启：从该 Unix 套接字上的旧进程接管监听套接字
+      {
+        handoffPath = optarg;
+        break;
+      }
       default:
         break;
     }
@@ -32,5 +50,16 @@ int main(int argc, char* argv[])
   muduo::Logger::setLogLevel(muduo::Logger::WARN);
   GomokuServer server(port, serverName);
   server.setThreadNum(4);
+  server.setWorkerThreadNum(16);
+  server.enableShardedListen(sharded);
+  if (accessLogSample > 0)
+  {
+    server.enableAccessLog(serverName + "_access", accessLogSample);
+  }
+  server.enableGracefulShutdown(30);
+  if (!handoffPath.empty())
+  {
+    server.enableHandoff(handoffPath);
+  }
   server.start();
 }
@@ -0,0 +1,340 @@
+#include "Bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// 用法：http_bench [--filter=子串] [--min-time=秒] [--json[=文件]] [--label=标签] [--list]
+// --json 输出机器可读的结果，--label 一般填当前提交号，便于把不同提交的结果放在一起比较
+namespace bench
+{
+
+namespace
+{
+
+struct Options
+{
+    std::string filter;
+    double      minTime = 0.5;
+    bool        json = false;
+    std::string jsonPath; // 为空时 JSON 写到标准输出
+    std::string label;
+    bool        list = false;
+};
+
+struct Result
+{
+    std::string name;
+    int         threads;
+    uint64_t    iterations; // 每个线程的迭代次数
+    double      seconds; // 墙钟时间
+    uint64_t    bytes; // 所有线程合计
+    uint64_t    items;
+    std::vector<std::pair<std::string, double>> counters; // 各线程的平均值
+};
+
+const uint64_t kMaxIterations = 1000000000;
+
+// 以给定迭代次数跑一轮，多线程时所有线程就绪后同时开始计时
+Result runOnce(const Benchmark& bm, uint64_t iterations)
+{
+    std::vector<State> states;
+    states.reserve(bm.threads);
+    for (int i = 0; i < bm.threads; ++i)
+    {
+        states.emplace_back(iterations, i, bm.threads);
+    }
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+    if (bm.threads == 1)
+    {
+        start = std::chrono::steady_clock::now();
+        bm.func(states[0]);
+        end = std::chrono::steady_clock::now();
+    }
+    else
+    {
+        std::atomic<int> ready(0);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < bm.threads; ++i)
+        {
+            threads.emplace_back([&, i] {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                {
+                }
+                bm.func(states[i]);
+            });
+        }
+        while (ready.load() < bm.threads)
+        {
+        }
+        start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        end = std::chrono::steady_clock::now();
+    }
+
+    Result result{bm.name, bm.threads, iterations,
+                  std::chrono::duration<double>(end - start).count(), 0, 0, {}};
+    for (const auto& state : states)
+    {
+        result.bytes += state.bytesProcessed();
+        result.items += state.itemsProcessed();
+    }
+    for (const auto& counter : states[0].counters())
+    {
+        double sum = 0;
+        for (const auto& state : states)
+        {
+            for (const auto& c : state.counters())
+            {
+                if (c.first == counter.first)
+                {
+                    sum += c.second;
+                }
+            }
+        }
+        result.counters.emplace_back(counter.first, sum / bm.threads);
+    }
+    return result;
+}
+
+// 迭代次数从 1 开始按耗时外推，直到单轮耗时达到 minTime
+Result run(const Benchmark& bm, double minTime)
+{
+    uint64_t iterations = 1;
+    while (true)
+    {
+        Result result = runOnce(bm, iterations);
+        if (result.seconds >= minTime || iterations >= kMaxIterations)
+        {
+            return result;
+        }
+        // 多估 40%，尽量一次外推就够；耗时太短测不准时每轮最多放大 10 倍
+        double multiplier = result.seconds > minTime / 100 ? minTime * 1.4 / result.seconds : 10;
+        multiplier = std::min(multiplier, 10.0);
+        uint64_t next = static_cast<uint64_t>(static_cast<double>(iterations) * multiplier);
+        iterations = std::min(std::max(next, iterations + 1), kMaxIterations);
+    }
+}
+
+double nanosPerOp(const Result& r)
+{
+    return r.seconds * 1e9 / static_cast<double>(r.iterations);
+}
+
+void printText(const Result& r)
+{
+    char line[256];
+    int n = snprintf(line, sizeof line, "%-40s %8d %12llu %12.1f",
+                     r.name.c_str(), r.threads,
+                     static_cast<unsigned long long>(r.iterations), nanosPerOp(r));
+    if (r.bytes > 0)
+    {
+        n += snprintf(line + n, sizeof line - n, " %10.1f MB/s", r.bytes / r.seconds / 1e6);
+    }
+    if (r.items > 0)
+    {
+        n += snprintf(line + n, sizeof line - n, " %12.0f items/s", r.items / r.seconds);
+    }
+    for (const auto& counter : r.counters)
+    {
+        if (n >= static_cast<int>(sizeof line))
+        {
+            break;
+        }
+        n += snprintf(line + n, sizeof line - n, " %s=%.4f", counter.first.c_str(), counter.second);
+    }
+    printf("%s\n", line);
+    fflush(stdout);
+}
+
+std::string jsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+void writeJson(FILE* out, const Options& options, const std::vector<Result>& results)
+{
+    char date[64];
+    time_t now = ::time(nullptr);
+    struct tm tm;
+    ::gmtime_r(&now, &tm);
+    ::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%SZ", &tm);
+    char host[256] = "";
+    ::gethostname(host, sizeof host - 1);
+
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": %s,\n", jsonString(date).c_str());
+    fprintf(out, "    \"label\": %s,\n", jsonString(options.label).c_str());
+    fprintf(out, "    \"host_name\": %s,\n", jsonString(host).c_str());
+    fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(out, "    \"compiler\": %s,\n", jsonString(__VERSION__).c_str());
+#ifdef NDEBUG
+    fprintf(out, "    \"build_type\": \"release\",\n");
+#else
+    fprintf(out, "    \"build_type\": \"debug\",\n");
+#endif
+    fprintf(out, "    \"min_time\": %g\n  },\n  \"benchmarks\": [", options.minTime);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r = results[i];
+        fprintf(out, "%s\n    {\"name\": %s, \"threads\": %d, \"iterations\": %llu, "
+                     "\"real_time_s\": %.9f, \"ns_per_op\": %.3f, "
+                     "\"bytes_per_second\": %.1f, \"items_per_second\": %.1f",
+                i == 0 ? "" : ",", jsonString(r.name).c_str(), r.threads,
+                static_cast<unsigned long long>(r.iterations), r.seconds, nanosPerOp(r),
+                r.bytes / r.seconds, r.items / r.seconds);
+        if (!r.counters.empty())
+        {
+            fprintf(out, ", \"counters\": {");
+            for (size_t j = 0; j < r.counters.size(); ++j)
+            {
+                fprintf(out, "%s%s: %.6f", j == 0 ? "" : ", ",
+                        jsonString(r.counters[j].first).c_str(), r.counters[j].second);
+            }
+            fprintf(out, "}");
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+bool parseOptions(int argc, char* argv[], Options* options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        if (::strncmp(arg, "--filter=", 9) == 0)
+        {
+            options->filter = arg + 9;
+        }
+        else if (::strncmp(arg, "--min-time=", 11) == 0)
+        {
+            options->minTime = ::atof(arg + 11);
+        }
+        else if (::strcmp(arg, "--json") == 0)
+        {
+            options->json = true;
+        }
+        else if (::strncmp(arg, "--json=", 7) == 0)
+        {
+            options->json = true;
+            options->jsonPath = arg + 7;
+        }
+        else if (::strncmp(arg, "--label=", 8) == 0)
+        {
+            options->label = arg + 8;
+        }
+        else if (::strcmp(arg, "--list") == 0)
+        {
+            options->list = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--filter=substr] [--min-time=seconds] "
+                            "[--json[=file]] [--label=name] [--list]\n", argv[0]);
+            return false;
+        }
+    }
+    return options->minTime > 0;
+}
+
+} // namespace
+
+std::vector<Benchmark>& registry()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+int registerBenchmark(const std::string& name, BenchFunc func, int threads)
+{
+    registry().push_back(Benchmark{name, std::move(func), std::max(threads, 1)});
+    return static_cast<int>(registry().size());
+}
+
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "benchmark check failed: %s\n", what);
+        ::exit(2);
+    }
+}
+
+} // namespace bench
+
+int main(int argc, char* argv[])
+{
+    bench::Options options;
+    if (!bench::parseOptions(argc, argv, &options))
+    {
+        return 1;
+    }
+
+    // JSON 写到标准输出时不再打印文本表格，保证输出可以直接被解析
+    bool text = !options.json || !options.jsonPath.empty();
+    if (text && !options.list)
+    {
+        printf("%-40s %8s %12s %12s\n", "benchmark", "threads", "iterations", "ns/op");
+    }
+
+    std::vector<bench::Result> results;
+    for (const auto& bm : bench::registry())
+    {
+        if (bm.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+        if (options.list)
+        {
+            printf("%s\n", bm.name.c_str());
+            continue;
+        }
+        results.push_back(bench::run(bm, options.minTime));
+        if (text)
+        {
+            bench::printText(results.back());
+        }
+    }
+
+    if (options.json && !options.list)
+    {
+        FILE* out = options.jsonPath.empty() ? stdout : ::fopen(options.jsonPath.c_str(), "w");
+        if (!out)
+        {
+            perror(options.jsonPath.c_str());
+            return 1;
+        }
+        bench::writeJson(out, options, results);
+        if (out != stdout)
+        {
+            ::fclose(out);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 自带的微基准测试框架，不依赖 Google Benchmark
+// 每个基准是一个 void(bench::State&) 函数，在 while (state.keepRunning()) 循环里执行被测代码；
+// 运行器自动增加迭代次数直到单轮耗时超过 --min-time，多线程基准由运行器同时启动多个线程执行同一个函数
+namespace bench
+{
+
+class State
+{
+public:
+    State(uint64_t iterations, int threadIndex, int threads)
+        : iterations_(iterations)
+        , count_(0)
+        , threadIndex_(threadIndex)
+        , threads_(threads)
+        , bytes_(0)
+        , items_(0)
+    {}
+
+    bool keepRunning()
+    { return count_++ < iterations_; }
+
+    // 本线程要执行的迭代次数
+    uint64_t iterations() const
+    { return iterations_; }
+
+    int threadIndex() const
+    { return threadIndex_; }
+
+    int threads() const
+    { return threads_; }
+
+    // 本线程处理的字节数 / 条目数，用于计算吞吐
+    void setBytesProcessed(uint64_t bytes)
+    { bytes_ = bytes; }
+
+    void setItemsProcessed(uint64_t items)
+    { items_ = items; }
+
+    uint64_t bytesProcessed() const
+    { return bytes_; }
+
+    uint64_t itemsProcessed() const
+    { return items_; }
+
+    // 吞吐之外的自定义指标（如缓存命中率），同名指标取各线程的平均值，随结果一起输出
+    void setCounter(const std::string& name, double value)
+    {
+        for (auto& counter : counters_)
+        {
+            if (counter.first == name)
+            {
+                counter.second = value;
+                return;
+            }
+        }
+        counters_.emplace_back(name, value);
+    }
+
+    const std::vector<std::pair<std::string, double>>& counters() const
+    { return counters_; }
+
+private:
+    uint64_t iterations_;
+    uint64_t count_;
+    int      threadIndex_;
+    int      threads_;
+    uint64_t bytes_;
+    uint64_t items_;
+    std::vector<std::pair<std::string, double>> counters_;
+};
+
+using BenchFunc = std::function<void (State&)>;
+
+struct Benchmark
+{
+    std::string name;
+    BenchFunc   func;
+    int         threads;
+};
+
+// 所有注册的基准，按注册顺序
+std::vector<Benchmark>& registry();
+
+// 注册一个基准；threads 大于 1 时由运行器同时启动这么多线程
+int registerBenchmark(const std::string& name, BenchFunc func, int threads = 1);
+
+// 结果校验失败时打印原因并退出，基准跑出错误结果时数字没有意义
+void check(bool ok, const char* what);
+
+// 阻止编译器把只为计时而计算的结果优化掉
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_INNER(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_INNER(a, b)
+
+// 在文件作用域注册基准：BENCHMARK("parse/curl_get", func) 或 BENCHMARK("cache/get", func, 4)
+#define BENCHMARK(...) \
+    static const int BENCH_CONCAT(benchRegistered_, __LINE__) = ::bench::registerBenchmark(__VA_ARGS__)
@@ -0,0 +1,160 @@
+#include "Bench.h"
+
+#include <memory>
+#include <vector>
+
+#include "../HttpServer/include/http/HttpResponse.h"
+#include "../http_cache/include/MemoryCacheLRU.h"
+#include "../http_cache/include/ShardedCacheLRU.h"
+
+// MemoryCacheLRU 与 ShardedCacheLRU（LRU / CLOCK 两种模式）：单线程和多线程下的命中读取，以及 90% 读 10% 写的混合负载
+namespace
+{
+
+const int kKeys = 4096;
+const size_t kBodyBytes = 1024;
+
+std::vector<http::cache::CacheKey> makeKeys()
+{
+    std::vector<http::cache::CacheKey> keys;
+    keys.reserve(kKeys);
+    for (int i = 0; i < kKeys; ++i)
+    {
+        keys.push_back(http::cache::CacheKey{"GET", "/api/v1/games/" + std::to_string(i) + "?view=full", "gzip"});
+    }
+    return keys;
+}
+
+const std::vector<http::cache::CacheKey>& sharedKeys()
+{
+    static const std::vector<http::cache::CacheKey> keys = makeKeys();
+    return keys;
+}
+
+http::cache::CachedEntryPtr makeEntry()
+{
+    http::HttpResponse resp(false);
+    resp.setStatusLine("HTTP/1.1", http::HttpResponse::k200Ok, "OK");
+    resp.setContentType("application/json");
+    resp.addHeader("Cache-Control", "public, max-age=60");
+    resp.addHeader("ETag", "\"5f2b-18c7a3e9d40\"");
+    resp.setContentLength(kBodyBytes);
+    resp.setBody(std::string(kBodyBytes, 'x'));
+
+    auto entry = std::make_shared<http::cache::CachedEntry>();
+    entry->headerBytes = resp.serializeForReuse(&entry->wire);
+    entry->status = 200;
+    entry->softExpire = std::chrono::steady_clock::now() + std::chrono::hours(1);
+    entry->hardExpire = entry->softExpire;
+    return entry;
+}
+
+const size_t kCapacityBytes = 64 * 1024 * 1024;
+
+enum StoreKind { kSingleLru, kShardedLru, kShardedClock };
+
+std::unique_ptr<http::cache::ICacheStore> makeStore(StoreKind kind)
+{
+    switch (kind)
+    {
+        case kShardedLru:
+            return std::make_unique<http::cache::ShardedCacheLRU>(kCapacityBytes, 16, false);
+        case kShardedClock:
+            return std::make_unique<http::cache::ShardedCacheLRU>(kCapacityBytes, 16, true);
+        default:
+            return std::make_unique<http::cache::MemoryCacheLRU>(kCapacityBytes);
+    }
+}
+
+// 容量足够放下全部键，所有读取都命中；各轮、各线程共用同一个缓存，预热只做一次
+template <StoreKind Kind>
+http::cache::ICacheStore& sharedCache()
+{
+    static std::unique_ptr<http::cache::ICacheStore> cache = [] {
+        auto store = makeStore(Kind);
+        http::cache::CachedEntryPtr entry = makeEntry();
+        for (const auto& key : sharedKeys())
+        {
+            store->set(key, entry);
+        }
+        return store;
+    }();
+    return *cache;
+}
+
+// 每个线程独立的 xorshift 随机数，避免共享随机数引擎本身成为争用点
+struct XorShift
+{
+    explicit XorShift(uint64_t seed) : x(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    uint64_t next()
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+
+    uint64_t x;
+};
+
+template <StoreKind Kind>
+void cacheGet(bench::State& state)
+{
+    http::cache::ICacheStore& cache = sharedCache<Kind>();
+    const auto& keys = sharedKeys();
+    XorShift rng(state.threadIndex());
+    while (state.keepRunning())
+    {
+        auto entry = cache.get(keys[rng.next() % kKeys]);
+        bench::check(entry != nullptr, "cache miss");
+        bench::doNotOptimize(entry->bytes());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+// 90% get，10% set（覆盖已有键，缓存大小保持不变）
+template <StoreKind Kind>
+void cacheMixed(bench::State& state)
+{
+    http::cache::ICacheStore& cache = sharedCache<Kind>();
+    const auto& keys = sharedKeys();
+    const http::cache::CachedEntryPtr entry = makeEntry();
+    XorShift rng(state.threadIndex());
+    while (state.keepRunning())
+    {
+        uint64_t r = rng.next();
+        const http::cache::CacheKey& key = keys[(r >> 8) % kKeys];
+        if (r % 10 == 0)
+        {
+            cache.set(key, entry);
+        }
+        else
+        {
+            auto hit = cache.get(key);
+            bench::doNotOptimize(hit.get());
+        }
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("cache/lru_get", cacheGet<kSingleLru>, 1);
+BENCHMARK("cache/lru_get", cacheGet<kSingleLru>, 4);
+BENCHMARK("cache/lru_get", cacheGet<kSingleLru>, 8);
+BENCHMARK("cache/lru_mixed_90_10", cacheMixed<kSingleLru>, 1);
+BENCHMARK("cache/lru_mixed_90_10", cacheMixed<kSingleLru>, 4);
+BENCHMARK("cache/lru_mixed_90_10", cacheMixed<kSingleLru>, 8);
+BENCHMARK("cache/sharded_lru_get", cacheGet<kShardedLru>, 1);
+BENCHMARK("cache/sharded_lru_get", cacheGet<kShardedLru>, 4);
+BENCHMARK("cache/sharded_lru_get", cacheGet<kShardedLru>, 8);
+BENCHMARK("cache/sharded_lru_mixed_90_10", cacheMixed<kShardedLru>, 1);
+BENCHMARK("cache/sharded_lru_mixed_90_10", cacheMixed<kShardedLru>, 4);
+BENCHMARK("cache/sharded_lru_mixed_90_10", cacheMixed<kShardedLru>, 8);
+BENCHMARK("cache/sharded_clock_get", cacheGet<kShardedClock>, 1);
+BENCHMARK("cache/sharded_clock_get", cacheGet<kShardedClock>, 4);
+BENCHMARK("cache/sharded_clock_get", cacheGet<kShardedClock>, 8);
+BENCHMARK("cache/sharded_clock_mixed_90_10", cacheMixed<kShardedClock>, 1);
+BENCHMARK("cache/sharded_clock_mixed_90_10", cacheMixed<kShardedClock>, 4);
+BENCHMARK("cache/sharded_clock_mixed_90_10", cacheMixed<kShardedClock>, 8);
+
+} // namespace
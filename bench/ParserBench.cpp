@@ -0,0 +1,152 @@
+#include "Bench.h"
+
+#include <algorithm>
+
+#include <muduo/net/Buffer.h>
+
+#include "../HttpServer/include/http/HttpContext.h"
+
+// HttpContext::parseRequest：整包到达、按不同粒度分片到达、流水线请求，以及 chunked 请求体
+namespace
+{
+
+// 浏览器打开对局菜单页时的真实请求
+const std::string kBrowserGet =
+    "GET /menu?tab=rank&page=2 HTTP/1.1\r\n"
+    "Host: gomoku.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Windows\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,"
+    "image/webp,image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: https://gomoku.example.com/entry\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Cookie: sessionId=3f9c2a7e5b1d4c8a9e0f6b2d7c1a5e3f; theme=dark\r\n"
+    "\r\n";
+
+// curl 健康检查
+const std::string kCurlGet =
+    "GET /health HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+std::string makePost(const std::string& path, const std::string& body)
+{
+    return "POST " + path + " HTTP/1.1\r\n"
+           "Host: gomoku.example.com\r\n"
+           "Connection: keep-alive\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "Origin: https://gomoku.example.com\r\n"
+           "Referer: https://gomoku.example.com/entry\r\n"
+           "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/605.1.15 "
+           "(KHTML, like Gecko) Version/17.4 Safari/605.1.15\r\n"
+           "Accept: */*\r\n"
+           "Accept-Language: zh-CN,zh-Hans;q=0.9\r\n"
+           "Accept-Encoding: gzip, deflate, br\r\n"
+           "\r\n" + body;
+}
+
+const std::string kLoginPost = makePost("/login", "{\"username\":\"alice\",\"password\":\"correct horse battery\"}");
+
+// 分块上传一段 4KB 的对局记录
+std::string makeChunkedPost()
+{
+    std::string request =
+        "POST /upload/record HTTP/1.1\r\n"
+        "Host: gomoku.example.com\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n";
+    std::string chunk(1024, 'x');
+    for (int i = 0; i < 4; ++i)
+    {
+        request += "400\r\n" + chunk + "\r\n";
+    }
+    request += "0\r\n\r\n";
+    return request;
+}
+
+const std::string kChunkedPost = makeChunkedPost();
+
+// 每次迭代把 raw 按 pieceSize 切片逐片追加并解析，模拟一个请求分多次 read 到达
+void parseSplit(bench::State& state, const std::string& raw, size_t pieceSize)
+{
+    http::HttpContext context;
+    muduo::net::Buffer buf;
+    muduo::Timestamp now = muduo::Timestamp::now();
+    while (state.keepRunning())
+    {
+        for (size_t offset = 0; offset < raw.size(); offset += pieceSize)
+        {
+            buf.append(raw.data() + offset, std::min(pieceSize, raw.size() - offset));
+            bench::check(context.parseRequest(&buf, now), "parseRequest failed");
+        }
+        bench::check(context.gotAll() && buf.readableBytes() == 0, "request not complete");
+        bench::doNotOptimize(context.request().path().size());
+        context.reset();
+    }
+    state.setBytesProcessed(state.iterations() * raw.size());
+    state.setItemsProcessed(state.iterations());
+}
+
+void parseWhole(bench::State& state, const std::string& raw)
+{
+    parseSplit(state, raw, raw.size());
+}
+
+// 一次读到 depth 个流水线请求，逐个解析
+void parsePipelined(bench::State& state, const std::string& raw, int depth)
+{
+    std::string batch;
+    for (int i = 0; i < depth; ++i)
+    {
+        batch += raw;
+    }
+    http::HttpContext context;
+    muduo::net::Buffer buf;
+    muduo::Timestamp now = muduo::Timestamp::now();
+    while (state.keepRunning())
+    {
+        buf.append(batch.data(), batch.size());
+        while (buf.readableBytes() > 0)
+        {
+            bench::check(context.parseRequest(&buf, now) && context.gotAll(), "pipelined parse failed");
+            bench::doNotOptimize(context.request().path().size());
+            context.reset();
+        }
+    }
+    state.setBytesProcessed(state.iterations() * batch.size());
+    state.setItemsProcessed(state.iterations() * depth);
+}
+
+BENCHMARK("parse/curl_get", [](bench::State& state) { parseWhole(state, kCurlGet); });
+BENCHMARK("parse/browser_get", [](bench::State& state) { parseWhole(state, kBrowserGet); });
+BENCHMARK("parse/login_post", [](bench::State& state) { parseWhole(state, kLoginPost); });
+BENCHMARK("parse/chunked_post_4k", [](bench::State& state) { parseWhole(state, kChunkedPost); });
+
+// 请求在中间断开，分两次到达
+BENCHMARK("parse/browser_get/split_half", [](bench::State& state) {
+    parseSplit(state, kBrowserGet, kBrowserGet.size() / 2 + 1);
+});
+// 小 MSS 或慢速客户端，请求头被切成很多小片
+BENCHMARK("parse/browser_get/split_64", [](bench::State& state) { parseSplit(state, kBrowserGet, 64); });
+// 每次只到一个字节，最坏情况
+BENCHMARK("parse/browser_get/split_1", [](bench::State& state) { parseSplit(state, kBrowserGet, 1); });
+BENCHMARK("parse/login_post/split_64", [](bench::State& state) { parseSplit(state, kLoginPost, 64); });
+BENCHMARK("parse/chunked_post_4k/split_512", [](bench::State& state) { parseSplit(state, kChunkedPost, 512); });
+
+BENCHMARK("parse/curl_get/pipelined_16", [](bench::State& state) { parsePipelined(state, kCurlGet, 16); });
+
+} // namespace
@@ -0,0 +1,95 @@
+#include "Bench.h"
+
+#include <muduo/net/Buffer.h>
+
+#include "../HttpServer/include/http/HttpResponse.h"
+
+// HttpResponse::appendToBuffer：响应对象提前构造好，只测序列化到输出缓冲区
+namespace
+{
+
+// 每次迭代把 resp 序列化进同一个缓冲区再清空，缓冲区容量在第一轮之后不再增长
+void appendResponse(bench::State& state, const http::HttpResponse& resp)
+{
+    muduo::net::Buffer buf;
+    size_t bytes = 0;
+    while (state.keepRunning())
+    {
+        resp.appendToBuffer(&buf);
+        bytes = buf.readableBytes();
+        bench::doNotOptimize(buf.peek());
+        buf.retrieveAll();
+    }
+    state.setBytesProcessed(state.iterations() * bytes);
+    state.setItemsProcessed(state.iterations());
+}
+
+// 典型的 JSON 接口响应
+http::HttpResponse makeJsonResponse()
+{
+    http::HttpResponse resp(false);
+    resp.setStatusLine("HTTP/1.1", http::HttpResponse::k200Ok, "OK");
+    resp.setContentType("application/json");
+    std::string body = "{\"success\":true,\"userId\":42,\"message\":\"login successful\"}";
+    resp.setContentLength(body.size());
+    resp.setBody(body);
+    return resp;
+}
+
+// 带缓存和安全相关头部的 4KB 页面
+http::HttpResponse makePageResponse()
+{
+    http::HttpResponse resp(false);
+    resp.setStatusLine("HTTP/1.1", http::HttpResponse::k200Ok, "OK");
+    resp.setContentType("text/html; charset=utf-8");
+    resp.addHeader("Cache-Control", "public, max-age=60");
+    resp.addHeader("ETag", "\"5f2b-18c7a3e9d40\"");
+    resp.addHeader("Last-Modified", "Tue, 14 May 2024 08:12:30 GMT");
+    resp.addHeader("Vary", "Accept-Encoding");
+    resp.addHeader("Access-Control-Allow-Origin", "https://gomoku.example.com");
+    resp.addHeader("X-Content-Type-Options", "nosniff");
+    std::string body(4096, 'a');
+    resp.setContentLength(body.size());
+    resp.setBody(body);
+    return resp;
+}
+
+// 非标准原因短语，走不到预先拼好的状态行
+http::HttpResponse makeCustomStatusResponse()
+{
+    http::HttpResponse resp(true);
+    resp.setStatusLine("HTTP/1.1", http::HttpResponse::k404NotFound, "Game Not Found");
+    resp.setContentType("application/json");
+    std::string body = "{\"error\":\"no such game\"}";
+    resp.setContentLength(body.size());
+    resp.setBody(body);
+    return resp;
+}
+
+// 响应缓存命中时的形态：makePageResponse 预先序列化好的字节，外加命中时追加的头部
+http::HttpResponse makeSerializedPageResponse()
+{
+    http::HttpResponse page = makePageResponse();
+    auto wire = std::make_shared<std::string>();
+    size_t headerBytes = page.serializeForReuse(wire.get());
+    http::HttpResponse resp(false);
+    resp.setSerialized(std::move(wire), headerBytes, http::HttpResponse::k200Ok);
+    resp.addHeader("Age", "0");
+    resp.addHeader("X-Cache", "HIT");
+    return resp;
+}
+
+BENCHMARK("response/json_small", [](bench::State& state) {
+    appendResponse(state, makeJsonResponse());
+});
+BENCHMARK("response/page_4k_headers_8", [](bench::State& state) {
+    appendResponse(state, makePageResponse());
+});
+BENCHMARK("response/page_4k_serialized", [](bench::State& state) {
+    appendResponse(state, makeSerializedPageResponse());
+});
+BENCHMARK("response/custom_status", [](bench::State& state) {
+    appendResponse(state, makeCustomStatusResponse());
+});
+
+} // namespace
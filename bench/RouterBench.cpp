@@ -0,0 +1,88 @@
+#include "Bench.h"
+
+#include <string.h>
+
+#include "../HttpServer/include/router/Router.h"
+
+// Router::route：精准路由命中、动态路由命中（首个/最后一个/通配）和未命中
+// 动态路由的基准名沿用 regex_*，便于和改成前缀树之前的结果对比
+namespace
+{
+
+const int kStaticRoutes = 32;
+
+// 路由表的规模和形状接近五子棋服务：若干页面和接口的精准路由，加上带参数的动态路由
+void registerRoutes(http::router::Router& r)
+{
+    auto ok = [](const http::HttpRequest&, http::HttpResponse* resp) {
+        resp->setStatusCode(http::HttpResponse::k200Ok);
+    };
+    r.registerCallback(http::HttpRequest::kGet, "/", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/entry", ok);
+    r.registerCallback(http::HttpRequest::kPost, "/login", ok);
+    r.registerCallback(http::HttpRequest::kPost, "/register", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/menu", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/aiBot/start", ok);
+    r.registerCallback(http::HttpRequest::kPost, "/aiBot/move", ok);
+    r.registerCallback(http::HttpRequest::kPost, "/user/logout", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/backend", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/backend_data", ok);
+    for (int i = 0; i < kStaticRoutes; ++i)
+    {
+        r.registerCallback(http::HttpRequest::kGet, "/api/v1/resource" + std::to_string(i), ok);
+    }
+    r.registerCallback(http::HttpRequest::kGet, "/api/users/:id", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/api/users/:id/games", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/api/rooms/:room/players/:player", ok);
+    r.registerCallback(http::HttpRequest::kPost, "/api/rooms/:room/moves", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/api/games/:gameId/moves/:moveId", ok);
+    r.registerCallback(http::HttpRequest::kGet, "/static/*file", ok);
+}
+
+// Router 里的 RouteKey 指向自己保存的路径，不能拷贝，只能原地构造
+http::router::Router& sharedRouter()
+{
+    static http::router::Router router;
+    static bool registered = (registerRoutes(router), true);
+    (void) registered;
+    return router;
+}
+
+void routeRequest(bench::State& state, http::HttpRequest::Method method, const std::string& path, bool expectHit)
+{
+    http::router::Router& router = sharedRouter();
+    http::HttpRequest req;
+    const char* methodName = method == http::HttpRequest::kPost ? "POST" : "GET";
+    req.setMethod(methodName, methodName + ::strlen(methodName));
+    req.setPath(path.data(), path.data() + path.size());
+    http::HttpResponse resp;
+    while (state.keepRunning())
+    {
+        bool hit = router.route(req, &resp);
+        bench::check(hit == expectHit, "unexpected route result");
+        bench::doNotOptimize(resp.getStatusCode());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("router/static_first", [](bench::State& state) {
+    routeRequest(state, http::HttpRequest::kGet, "/", true);
+});
+BENCHMARK("router/static_deep", [](bench::State& state) {
+    routeRequest(state, http::HttpRequest::kGet, "/api/v1/resource" + std::to_string(kStaticRoutes - 1), true);
+});
+BENCHMARK("router/regex_first", [](bench::State& state) {
+    routeRequest(state, http::HttpRequest::kGet, "/api/users/10086", true);
+});
+BENCHMARK("router/regex_last", [](bench::State& state) {
+    routeRequest(state, http::HttpRequest::kGet, "/api/games/731/moves/56", true);
+});
+BENCHMARK("router/wildcard", [](bench::State& state) {
+    routeRequest(state, http::HttpRequest::kGet, "/static/js/board/render.min.js", true);
+});
+// 404 请求的开销
+BENCHMARK("router/miss", [](bench::State& state) {
+    routeRequest(state, http::HttpRequest::kGet, "/favicon.ico", false);
+});
+
+} // namespace
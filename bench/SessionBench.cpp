@@ -0,0 +1,94 @@
+#include "Bench.h"
+
+#include <vector>
+
+#include <muduo/net/Buffer.h>
+
+#include "../HttpServer/include/http/HttpContext.h"
+#include "../HttpServer/include/session/SessionManager.h"
+
+// SessionManager::getSession：带有效会话 Cookie 的请求（最常见），以及没有 Cookie 需要新建会话的请求
+namespace
+{
+
+const int kMaxThreads = 8;
+
+// 用 HttpContext 解析一段原始请求，得到和线上一样填好请求头的 HttpRequest
+void parseInto(const std::string& raw, http::HttpRequest* req)
+{
+    http::HttpContext context;
+    muduo::net::Buffer buf;
+    buf.append(raw.data(), raw.size());
+    bench::check(context.parseRequest(&buf, muduo::Timestamp::now()) && context.gotAll(), "parse failed");
+    req->swap(context.request());
+}
+
+std::string requestWithCookie(const std::string& sessionId)
+{
+    return "GET /menu HTTP/1.1\r\n"
+           "Host: gomoku.example.com\r\n"
+           "Accept: text/html\r\n"
+           "Cookie: theme=dark; sessionId=" + sessionId + "; lang=zh-CN\r\n"
+           "\r\n";
+}
+
+// 会话管理器和每个线程各自的一个会话在第一次使用时一次建好，计时的部分只读取已有会话
+struct SessionFixture
+{
+    SessionFixture()
+        : manager(std::make_unique<http::session::MemorySessionStorage>())
+    {
+        http::HttpRequest req;
+        parseInto("GET / HTTP/1.1\r\nHost: gomoku.example.com\r\n\r\n", &req);
+        for (int i = 0; i < kMaxThreads; ++i)
+        {
+            http::HttpResponse resp;
+            sessionIds.push_back(manager.getSession(req, &resp)->getId());
+        }
+    }
+
+    http::session::SessionManager manager;
+    std::vector<std::string>      sessionIds;
+};
+
+SessionFixture& sharedFixture()
+{
+    static SessionFixture fixture;
+    return fixture;
+}
+
+void getExisting(bench::State& state)
+{
+    SessionFixture& fixture = sharedFixture();
+    http::HttpRequest req;
+    parseInto(requestWithCookie(fixture.sessionIds[state.threadIndex()]), &req);
+    http::HttpResponse resp;
+    while (state.keepRunning())
+    {
+        auto session = fixture.manager.getSession(req, &resp);
+        bench::doNotOptimize(session.get());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+// 每次新建的会话随即销毁，存储的大小不随迭代次数增长
+void getNew(bench::State& state)
+{
+    http::session::SessionManager manager(std::make_unique<http::session::MemorySessionStorage>());
+    http::HttpRequest req;
+    parseInto("GET / HTTP/1.1\r\nHost: gomoku.example.com\r\nAccept: text/html\r\n\r\n", &req);
+    while (state.keepRunning())
+    {
+        http::HttpResponse resp;
+        auto session = manager.getSession(req, &resp);
+        manager.destroySession(session->getId());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("session/get_existing", getExisting, 1);
+BENCHMARK("session/get_existing", getExisting, 4);
+BENCHMARK("session/get_existing", getExisting, kMaxThreads);
+BENCHMARK("session/get_new", getNew, 1);
+
+} // namespace
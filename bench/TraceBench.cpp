@@ -0,0 +1,256 @@
+#include "Bench.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "../http_cache/include/MemoryCacheLRU.h"
+#include "../http_cache/include/ShardedCacheLRU.h"
+#include "../http_cache/include/TinyLfuCache.h"
+
+// 响应缓存在一段可重放的请求序列上的命中率：每轮用新建的存储把整段序列回放一遍，
+// 未命中的请求随即写入（相当于路由处理完后 CacheMiddleware::after 写缓存），命中率作为 hit_ratio 输出。
+// 内置序列：五千个游戏页面按 Zipf 分布访问，其间穿插爬虫逐个扫过只出现一次的 URL；
+// 设置环境变量 HTTP_BENCH_TRACE 时额外回放文件中的序列，每行 "路径 [响应字节数]"，
+// 例如从访问日志中取出路径列，HTTP_BENCH_TRACE_CAPACITY_MB 指定缓存容量
+namespace
+{
+
+struct TraceRequest
+{
+    http::cache::CacheKey       key;
+    http::cache::CachedEntryPtr entry; // 同样大小的响应共用一个条目，存储按 bytes() 计容量
+};
+
+using Trace = std::vector<TraceRequest>;
+
+const size_t kCapacityBytes = 8 * 1024 * 1024;
+const int kHotPages = 5000;
+const double kZipfExponent = 0.9;
+
+http::cache::CachedEntryPtr entryOfSize(size_t bytes)
+{
+    static std::map<size_t, http::cache::CachedEntryPtr> entries;
+    auto& entry = entries[bytes];
+    if (!entry)
+    {
+        auto e = std::make_shared<http::cache::CachedEntry>();
+        e->wire.assign(bytes, 'x');
+        e->status = 200;
+        entry = std::move(e);
+    }
+    return entry;
+}
+
+struct XorShift
+{
+    explicit XorShift(uint64_t seed) : x(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    uint64_t next()
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+
+    double uniform()
+    { return static_cast<double>(next() >> 11) / static_cast<double>(1ULL << 53); }
+
+    uint64_t x;
+};
+
+// 排名为 i 的元素被抽到的概率与 1 / (i + 1)^s 成正比
+class ZipfSampler
+{
+public:
+    ZipfSampler(int n, double s)
+        : cdf_(n)
+    {
+        double sum = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            sum += 1.0 / std::pow(i + 1, s);
+            cdf_[i] = sum;
+        }
+        for (auto& c : cdf_)
+        {
+            c /= sum;
+        }
+    }
+
+    int sample(XorShift* rng) const
+    {
+        auto it = std::lower_bound(cdf_.begin(), cdf_.end(), rng->uniform());
+        return static_cast<int>(std::min<ptrdiff_t>(it - cdf_.begin(), cdf_.size() - 1));
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+http::cache::CacheKey keyFor(const std::string& path)
+{
+    return http::cache::CacheKey{"GET", path, "gzip"};
+}
+
+// 固定种子生成，每次运行完全相同：4 个周期，每个周期先是 3 万个正常请求，
+// 再是 2 万个请求的爬虫时段，其中 70% 是只出现一次的新 URL
+Trace makeSyntheticTrace()
+{
+    XorShift rng(2024);
+    ZipfSampler zipf(kHotPages, kZipfExponent);
+    std::vector<std::string> pages;
+    std::vector<size_t> sizes;
+    pages.push_back("/menu");
+    sizes.push_back(6 * 1024);
+    pages.push_back("/backend_data");
+    sizes.push_back(12 * 1024);
+    while (static_cast<int>(pages.size()) < kHotPages)
+    {
+        pages.push_back("/game/" + std::to_string(pages.size()));
+        sizes.push_back((2 + rng.next() % 11) * 1024);
+    }
+
+    Trace trace;
+    int crawled = 0;
+    auto hot = [&] {
+        int i = zipf.sample(&rng);
+        trace.push_back(TraceRequest{keyFor(pages[i]), entryOfSize(sizes[i])});
+    };
+    for (int cycle = 0; cycle < 4; ++cycle)
+    {
+        for (int i = 0; i < 30000; ++i)
+        {
+            hot();
+        }
+        for (int i = 0; i < 20000; ++i)
+        {
+            if (rng.next() % 10 < 7)
+            {
+                std::string path = "/game/" + std::to_string(crawled % kHotPages) +
+                                   "/moves?page=" + std::to_string(crawled);
+                ++crawled;
+                trace.push_back(TraceRequest{keyFor(path), entryOfSize(4 * 1024)});
+            }
+            else
+            {
+                hot();
+            }
+        }
+    }
+    return trace;
+}
+
+Trace loadTraceFile(const char* path)
+{
+    Trace trace;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string target;
+        size_t bytes = 4096;
+        if (!(fields >> target))
+        {
+            continue;
+        }
+        fields >> bytes;
+        trace.push_back(TraceRequest{keyFor(target), entryOfSize(std::max<size_t>(bytes, 1))});
+    }
+    bench::check(!trace.empty(), "HTTP_BENCH_TRACE is empty or unreadable");
+    return trace;
+}
+
+const Trace& syntheticTrace()
+{
+    static const Trace trace = makeSyntheticTrace();
+    return trace;
+}
+
+const Trace& fileTrace()
+{
+    static const Trace trace = loadTraceFile(::getenv("HTTP_BENCH_TRACE"));
+    return trace;
+}
+
+size_t fileTraceCapacity()
+{
+    const char* mb = ::getenv("HTTP_BENCH_TRACE_CAPACITY_MB");
+    return mb ? static_cast<size_t>(::atof(mb) * 1024 * 1024) : kCapacityBytes;
+}
+
+enum StoreKind { kLru, kShardedClock, kTinyLfu };
+
+std::unique_ptr<http::cache::ICacheStore> makeStore(StoreKind kind, size_t capacity)
+{
+    switch (kind)
+    {
+        case kShardedClock:
+            return std::make_unique<http::cache::ShardedCacheLRU>(capacity, 16, true);
+        case kTinyLfu:
+            return std::make_unique<http::cache::TinyLfuCache>(capacity);
+        default:
+            return std::make_unique<http::cache::MemoryCacheLRU>(capacity);
+    }
+}
+
+void replay(bench::State& state, const Trace& trace, StoreKind kind, size_t capacity)
+{
+    uint64_t hits = 0;
+    uint64_t requests = 0;
+    while (state.keepRunning())
+    {
+        auto store = makeStore(kind, capacity);
+        for (const auto& request : trace)
+        {
+            if (store->get(request.key))
+            {
+                ++hits;
+            }
+            else
+            {
+                store->set(request.key, request.entry);
+            }
+        }
+        requests += trace.size();
+    }
+    state.setItemsProcessed(requests);
+    state.setCounter("hit_ratio", requests ? static_cast<double>(hits) / requests : 0);
+}
+
+template <StoreKind Kind>
+void replaySynthetic(bench::State& state)
+{
+    replay(state, syntheticTrace(), Kind, kCapacityBytes);
+}
+
+template <StoreKind Kind>
+void replayFile(bench::State& state)
+{
+    replay(state, fileTrace(), Kind, fileTraceCapacity());
+}
+
+BENCHMARK("trace/zipf_crawl/lru", replaySynthetic<kLru>);
+BENCHMARK("trace/zipf_crawl/sharded_clock", replaySynthetic<kShardedClock>);
+BENCHMARK("trace/zipf_crawl/tinylfu", replaySynthetic<kTinyLfu>);
+
+// 只有设置了 HTTP_BENCH_TRACE 才注册
+const bool kFileTraceRegistered = [] {
+    if (::getenv("HTTP_BENCH_TRACE"))
+    {
+        bench::registerBenchmark("trace/file/lru", replayFile<kLru>);
+        bench::registerBenchmark("trace/file/sharded_clock", replayFile<kShardedClock>);
+        bench::registerBenchmark("trace/file/tinylfu", replayFile<kTinyLfu>);
+    }
+    return true;
+}();
+
+} // namespace
@@ -1,25 +1,28 @@
-
 #pragma once
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <string>
-#include <utility>
-#include <vector>
 
 namespace http::cache {
 
+// 缓存的是序列化好的响应：状态行 + 头部（不含 Connection / Date）+ 响应体，
+// 命中时整段交给 HttpResponse::setSerialized，写进输出缓冲区时不再解析、不再逐个拼头部。
+// 条目写入存储后不再修改，以 CachedEntryPtr 在存储、命中的响应和发送之间共享
 struct CachedEntry {
-  std::string statusLine;
-  std::vector<std::pair<std::string,std::string>> headers;
-  std::string body;
+  std::string wire;
+  size_t headerBytes = 0; // wire 中状态行和头部部分的长度，其后是响应体
+  int    status = 0;
 
   std::chrono::steady_clock::time_point hardExpire;
   std::chrono::steady_clock::time_point softExpire;
 
-  size_t bytes() const {
-    size_t n = statusLine.size() + body.size();
-    for (auto &h: headers) n += h.first.size() + h.second.size();
-    return n;
-  }
+  // 软过期后第一个命中把它置位并发起后台刷新，其余命中看到已置位就只返回旧内容
+  mutable std::atomic<bool> revalidating{false};
+
+  size_t bytes() const { return wire.size(); }
 };
 
+using CachedEntryPtr = std::shared_ptr<const CachedEntry>;
+
 } // namespace http::cache
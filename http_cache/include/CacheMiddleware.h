@@ -1,11 +1,14 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "../../HttpServer/include/http/HttpHeaders.h"
 #include "CachePolicy.h"
 #include "ICacheStore.h"   // 间接引入 CacheKey / CacheEntry
 
@@ -21,27 +24,30 @@ class CacheMiddleware {
   std::shared_ptr<ICacheStore> store_;
 
   // === 适配你项目 API 的 helper（类内 static；在 .cpp 里用 CacheMiddleware:: 前缀实现）===
-  static std::string getMethod(const http::HttpRequest& req);
+  static std::string_view getMethod(const http::HttpRequest& req);
   static std::string getPathWithQuery(const http::HttpRequest& req);
-  static std::string getHeader(const http::HttpRequest& req, const std::string& k);
+  static std::string_view getHeader(const http::HttpRequest& req, http::KnownHeader k);
 
   static int         getStatus(const http::HttpResponse& resp);
-  static std::string getBody(const http::HttpResponse& resp);
   static void        addHeader(http::HttpResponse* resp, const std::string& k, const std::string& v);
   static bool        hasNoStore(const http::HttpResponse& resp);
-  static std::vector<std::pair<std::string,std::string>> dumpHeaders(const http::HttpResponse& resp);
-  static std::string dumpStatusLine(const http::HttpResponse& resp);
-  static void        setFromEntry(const CachedEntry& e, http::HttpResponse* out);
+  static void        setFromEntry(const CachedEntryPtr& e, http::HttpResponse* out);
 
   // 策略 / 打包
   static bool        isCacheableRequest(const http::HttpRequest& req, const CachePolicy& p);
   static bool        isCacheableResponse(const http::HttpResponse& resp, const CachePolicy& p);
   static CacheKey    makeKey(const http::HttpRequest& req, const CachePolicy& p);
-  static CachedEntry pack(const http::HttpResponse& resp,
+  bool store(const http::HttpRequest& req, const http::HttpResponse& resp);
+
+  static CachedEntryPtr pack(const http::HttpResponse& resp,
                           std::chrono::steady_clock::time_point now,
                           const CachePolicy& p);
 
 public:
+  // 后台刷新：以请求和软过期的条目调用，发起异步的重新生成并返回 true；无法发起时返回 false，
+  // 重新生成的响应交给 finishRevalidation
+  using Revalidator = std::function<bool (const http::HttpRequest& req, const CachedEntryPtr& stale)>;
+
   CacheMiddleware(CachePolicy p, std::shared_ptr<ICacheStore> s)
     : policy_(p), store_(std::move(s)) {}
 
@@ -51,6 +57,16 @@ public:
 
   // 前缀失效
   void purgePrefix(const std::string& prefix) { store_->purgePrefix(prefix); }
+
+  // 设置后软过期命中才会触发后台刷新，需在开始处理请求之前设置
+  void setRevalidator(Revalidator r) { revalidator_ = std::move(r); }
+
+  // 后台重新生成的响应写回缓存；响应不可缓存（如处理出错）时清除标记，之后的软过期命中会再次尝试
+  void finishRevalidation(const http::HttpRequest& req, const http::HttpResponse& resp,
+                          const CachedEntryPtr& stale);
+
+private:
+  Revalidator revalidator_;
 };
 
 } // namespace http::cache
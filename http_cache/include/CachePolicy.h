@@ -18,8 +18,22 @@ struct CachePolicy {
   size_t memoryCapacityBytes = 64ull * 1024 * 1024; // 64MB
   size_t maxObjectBytes      = 1ull * 1024 * 1024;  // 1MB
 
+  // 内存缓存的淘汰策略：Lru 按最近使用淘汰；TinyLfu 为 W-TinyLFU，按访问频率决定新条目能否进入主区，
+  // 一次性扫过大量新 URL 的流量不会把热点挤出去（见 TinyLfuCache，不分片，忽略下面两项）
+  enum class Eviction { Lru, TinyLfu };
+  Eviction eviction = Eviction::Lru;
+
+  // 内存缓存的分片数（向上取整为 2 的幂），1 表示单锁的 MemoryCacheLRU
+  size_t memoryShards = 16;
+  // 分片缓存命中时只置访问位（CLOCK），不在独占锁下调整 LRU 顺序
+  bool   clockRecency = true;
+
   std::chrono::seconds ttl{300};
   std::chrono::seconds staleWhileRevalidate{60};
+  // 软过期命中时在后台重新执行一次路由刷新条目（同一条目同时只刷新一次），条目在彻底过期前就被替换。
+  // 刷新在 HttpServer 的工作线程池中执行，没有工作线程池（setWorkerThreadNum 为 0）时不生效，
+  // 软过期条目照常返回，彻底过期后由下一个请求重新生成
+  bool backgroundRevalidate = true;
 
   bool varyAcceptEncoding   = true;
   bool respectNoStore       = true;
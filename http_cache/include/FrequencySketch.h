@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace http::cache {
+
+// 估计每个键最近被访问的次数（Count-Min Sketch，4 行 4 位计数器，上限 15）。
+// 累计增加次数达到 10 倍宽度时所有计数减半，旧的热度逐渐衰减，频率反映的是最近一段时间的访问。
+// 不是线程安全的，由调用方加锁
+class FrequencySketch {
+public:
+  // expectedEntries：缓存中预计的条目数，决定每行的宽度
+  explicit FrequencySketch(size_t expectedEntries);
+
+  void increment(uint64_t hash);
+  int  frequency(uint64_t hash) const;
+
+private:
+  static const int kDepth = 4;
+
+  size_t indexOf(uint64_t hash, int row) const;
+  int    counterAt(size_t index) const;
+  void   reset();
+
+  std::vector<uint64_t> table_; // 每个 uint64_t 存 16 个 4 位计数器，各行依次排列
+  size_t   width_;              // 每行的计数器个数，2 的幂
+  int      widthBits_;
+  size_t   sampleSize_;
+  size_t   additions_ = 0;
+};
+
+} // namespace http::cache
@@ -2,7 +2,6 @@
 #pragma once
 #include "CacheKey.h"
 #include "CacheEntry.h"
-#include <optional>
 #include <string>
 
 namespace http::cache {
@@ -10,8 +9,9 @@ namespace http::cache {
 class ICacheStore {
 public:
   virtual ~ICacheStore() = default;
-  virtual std::optional<CachedEntry> get(const CacheKey& key) = 0;
-  virtual void set(const CacheKey& key, const CachedEntry& e) = 0;
+  // 未命中时返回空指针；返回的条目不可变，持有期间不受淘汰和覆盖影响
+  virtual CachedEntryPtr get(const CacheKey& key) = 0;
+  virtual void set(const CacheKey& key, CachedEntryPtr e) = 0;
   virtual void del(const CacheKey& key) = 0;
   virtual void purgePrefix(const std::string& pathPrefix) = 0;
 };
@@ -8,11 +8,11 @@
 namespace http::cache {
 
 class MemoryCacheLRU : public ICacheStore {
-  using ListIt = std::list<std::pair<CacheKey, CachedEntry>>::iterator;
+  using ListIt = std::list<std::pair<CacheKey, CachedEntryPtr>>::iterator;
 
   size_t capBytes_;
   size_t usedBytes_{0};
-  std::list<std::pair<CacheKey, CachedEntry>> lru_;
+  std::list<std::pair<CacheKey, CachedEntryPtr>> lru_;
   std::unordered_map<CacheKey, ListIt, CacheKeyHash> map_;
   mutable std::shared_mutex mu_;
 
@@ -21,8 +21,8 @@ class MemoryCacheLRU : public ICacheStore {
 public:
   explicit MemoryCacheLRU(size_t capBytes);
 
-  std::optional<CachedEntry> get(const CacheKey& key) override;
-  void set(const CacheKey& key, const CachedEntry& e) override;
+  CachedEntryPtr get(const CacheKey& key) override;
+  void set(const CacheKey& key, CachedEntryPtr e) override;
   void del(const CacheKey& key) override;
   void purgePrefix(const std::string& pathPrefix) override;
 };
@@ -0,0 +1,58 @@
+#pragma once
+#include "ICacheStore.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace http::cache {
+
+// 分片 LRU：键按哈希分到 N 个互相独立的分片，每个分片有自己的锁和 capBytes / N 的字节预算，
+// 不同分片上的读写互不阻塞。
+// clockRecency 为 true 时命中只在共享锁下置一个访问位（CLOCK / second-chance），
+// 并发的命中可以同时进行；淘汰时从队尾扫描，访问位为 1 的清零后挪回队首再给一次机会。
+// 为 false 时命中在独占锁下把条目挪到队首，是精确的 LRU 顺序。
+class ShardedCacheLRU : public ICacheStore {
+public:
+  // shards 会向上取整为 2 的幂
+  ShardedCacheLRU(size_t capBytes, size_t shards = 16, bool clockRecency = true);
+
+  CachedEntryPtr get(const CacheKey& key) override;
+  void set(const CacheKey& key, CachedEntryPtr e) override;
+  void del(const CacheKey& key) override;
+  void purgePrefix(const std::string& pathPrefix) override;
+
+  size_t shardCount() const { return shardCount_; }
+
+private:
+  struct Node {
+    Node(const CacheKey& k, CachedEntryPtr e) : key(k), entry(std::move(e)), bytes(entry->bytes()) {}
+
+    CacheKey          key;
+    CachedEntryPtr    entry;
+    size_t            bytes;
+    std::atomic<bool> referenced{false}; // CLOCK 模式下的访问位，共享锁下也可以写
+  };
+  using ListIt = std::list<Node>::iterator;
+
+  // 按缓存行对齐，相邻分片的锁不会落在同一缓存行上
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mu;
+    std::list<Node> lru; // 队首最近使用
+    std::unordered_map<CacheKey, ListIt, CacheKeyHash> map;
+    size_t usedBytes = 0;
+  };
+
+  Shard& shardFor(const CacheKey& key);
+  void evictIfNeeded(Shard& s);
+  void erase(Shard& s, ListIt it);
+
+  size_t capPerShard_;
+  size_t shardCount_;
+  int    shardShift_;
+  bool   clockRecency_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+} // namespace http::cache
@@ -0,0 +1,60 @@
+#pragma once
+#include "FrequencySketch.h"
+#include "ICacheStore.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace http::cache {
+
+// W-TinyLFU：新条目先进入占容量 1% 的窗口 LRU；被挤出窗口时作为候选者，
+// 与主区 probation 段队尾的条目比较 FrequencySketch 估计的访问频率，频率更高才准入，否则直接丢弃。
+// 主区是分段 LRU：probation 中再次命中的条目升入 protected（占主区 80%），protected 溢出时降回 probation。
+// 一次性扫过大量新 URL 的流量（爬虫等）频率都是 1，只会在窗口里轮转，挤不掉主区的热点。
+// 每次访问都要更新频率和顺序，整个存储一把互斥锁
+class TinyLfuCache : public ICacheStore {
+public:
+  // expectedEntries 为 0 时按平均 4KB 一个条目估计
+  explicit TinyLfuCache(size_t capBytes, size_t expectedEntries = 0);
+
+  CachedEntryPtr get(const CacheKey& key) override;
+  void set(const CacheKey& key, CachedEntryPtr e) override;
+  void del(const CacheKey& key) override;
+  void purgePrefix(const std::string& pathPrefix) override;
+
+private:
+  enum Region { kWindow, kProbation, kProtected };
+
+  struct Node {
+    CacheKey       key;
+    CachedEntryPtr entry;
+    size_t         bytes;
+    uint64_t       hash;
+    Region         region;
+  };
+  using List = std::list<Node>;
+  using ListIt = List::iterator;
+
+  List&   listOf(Region r);
+  size_t& bytesOf(Region r);
+  void    moveTo(ListIt it, Region r);
+  void    erase(ListIt it);
+  void    onHit(ListIt it);
+  void    evictIfNeeded();
+  size_t  mainBytes() const { return probationBytes_ + protectedBytes_; }
+
+  size_t windowCap_;
+  size_t mainCap_;
+  size_t protectedCap_;
+
+  size_t windowBytes_    = 0;
+  size_t probationBytes_ = 0;
+  size_t protectedBytes_ = 0;
+
+  List window_, probation_, protected_; // 队首最近使用
+  std::unordered_map<CacheKey, ListIt, CacheKeyHash> map_;
+  FrequencySketch sketch_;
+  std::mutex mu_;
+};
+
+} // namespace http::cache
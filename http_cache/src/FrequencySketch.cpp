@@ -0,0 +1,66 @@
+#include "http_cache/include/FrequencySketch.h"
+
+#include <algorithm>
+
+using namespace http::cache;
+
+namespace {
+
+// 每行使用不同的乘数打散哈希，行与行之间的碰撞互不相关
+const uint64_t kSeeds[] = {
+  0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+  0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL,
+};
+
+const uint64_t kResetMask = 0x7777777777777777ULL; // 每个 4 位计数器右移一位后清掉借来的高位
+
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expectedEntries) {
+  width_ = 64;
+  widthBits_ = 6;
+  while (width_ < expectedEntries) {
+    width_ <<= 1;
+    ++widthBits_;
+  }
+  table_.assign(kDepth * width_ / 16, 0);
+  sampleSize_ = 10 * width_;
+}
+
+size_t FrequencySketch::indexOf(uint64_t hash, int row) const {
+  uint64_t h = (hash ^ (hash >> 29)) * kSeeds[row];
+  return row * width_ + (h >> (64 - widthBits_));
+}
+
+int FrequencySketch::counterAt(size_t index) const {
+  return static_cast<int>((table_[index >> 4] >> ((index & 15) * 4)) & 0xf);
+}
+
+int FrequencySketch::frequency(uint64_t hash) const {
+  int freq = 15;
+  for (int row = 0; row < kDepth; ++row)
+    freq = std::min(freq, counterAt(indexOf(hash, row)));
+  return freq;
+}
+
+// 保守更新：只增加等于当前最小值的计数器，减少碰撞带来的高估
+void FrequencySketch::increment(uint64_t hash) {
+  size_t index[kDepth];
+  int freq = 15;
+  for (int row = 0; row < kDepth; ++row) {
+    index[row] = indexOf(hash, row);
+    freq = std::min(freq, counterAt(index[row]));
+  }
+  if (freq == 15) return;
+
+  for (int row = 0; row < kDepth; ++row) {
+    if (counterAt(index[row]) == freq)
+      table_[index[row] >> 4] += uint64_t(1) << ((index[row] & 15) * 4);
+  }
+  if (++additions_ >= sampleSize_) reset();
+}
+
+void FrequencySketch::reset() {
+  for (auto& word : table_) word = (word >> 1) & kResetMask;
+  additions_ /= 2;
+}
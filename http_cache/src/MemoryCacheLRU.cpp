@@ -6,33 +6,37 @@ MemoryCacheLRU::MemoryCacheLRU(size_t capBytes) : capBytes_(capBytes) {}
 
 void MemoryCacheLRU::evictIfNeeded() {
   while (usedBytes_ > capBytes_ && !lru_.empty()) {
-    usedBytes_ -= lru_.back().second.bytes();
+    usedBytes_ -= lru_.back().second->bytes();
     map_.erase(lru_.back().first);
     lru_.pop_back();
   }
 }
 
-std::optional<CachedEntry> MemoryCacheLRU::get(const CacheKey& key) {
+// 锁内只做查找、调整顺序和一次引用计数加一，与条目大小无关
+CachedEntryPtr MemoryCacheLRU::get(const CacheKey& key) {
   std::unique_lock lock(mu_);
   auto it = map_.find(key);
-  if (it == map_.end()) return std::nullopt;
+  if (it == map_.end()) return nullptr;
   lru_.splice(lru_.begin(), lru_, it->second);
   return it->second->second;
 }
 
-void MemoryCacheLRU::set(const CacheKey& key, const CachedEntry& e) {
-  std::unique_lock lock(mu_);
-  size_t sz = e.bytes();
+void MemoryCacheLRU::set(const CacheKey& key, CachedEntryPtr e) {
+  size_t sz = e->bytes();
   if (sz > capBytes_) return;
 
+  // 被替换的旧条目在解锁之后释放，大响应体的 free 不占用锁
+  CachedEntryPtr old;
+  std::unique_lock lock(mu_);
   auto it = map_.find(key);
   if (it != map_.end()) {
-    usedBytes_ -= it->second->second.bytes();
-    it->second->second = e;
+    usedBytes_ -= it->second->second->bytes();
+    old = std::move(it->second->second);
+    it->second->second = std::move(e);
     usedBytes_ += sz;
     lru_.splice(lru_.begin(), lru_, it->second);
   } else {
-    lru_.emplace_front(key, e);
+    lru_.emplace_front(key, std::move(e));
     map_[key] = lru_.begin();
     usedBytes_ += sz;
   }
@@ -43,7 +47,7 @@ void MemoryCacheLRU::del(const CacheKey& key) {
   std::unique_lock lock(mu_);
   auto it = map_.find(key);
   if (it == map_.end()) return;
-  usedBytes_ -= it->second->second.bytes();
+  usedBytes_ -= it->second->second->bytes();
   lru_.erase(it->second);
   map_.erase(it);
 }
@@ -52,7 +56,7 @@ void MemoryCacheLRU::purgePrefix(const std::string& prefix) {
   std::unique_lock lock(mu_);
   for (auto it = lru_.begin(); it != lru_.end(); ) {
     if (it->first.pathAndQuery.rfind(prefix, 0) == 0) {
-      usedBytes_ -= it->second.bytes();
+      usedBytes_ -= it->second->bytes();
       map_.erase(it->first);
       it = lru_.erase(it);
     } else ++it;
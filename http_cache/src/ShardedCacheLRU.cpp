@@ -0,0 +1,127 @@
+#include "http_cache/include/ShardedCacheLRU.h"
+#include <mutex>
+
+using namespace http::cache;
+
+namespace {
+
+size_t roundUpPow2(size_t n) {
+  size_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+int log2Of(size_t pow2) {
+  int bits = 0;
+  while ((size_t(1) << bits) < pow2) ++bits;
+  return bits;
+}
+
+} // namespace
+
+ShardedCacheLRU::ShardedCacheLRU(size_t capBytes, size_t shards, bool clockRecency)
+  : shardCount_(roundUpPow2(shards == 0 ? 1 : shards)),
+    shardShift_(64 - log2Of(shardCount_)),
+    clockRecency_(clockRecency),
+    shards_(new Shard[shardCount_]) {
+  capPerShard_ = capBytes / shardCount_;
+}
+
+ShardedCacheLRU::Shard& ShardedCacheLRU::shardFor(const CacheKey& key) {
+  if (shardCount_ == 1) return shards_[0];
+  // CacheKeyHash 的低位分布一般，乘以黄金比例常数后取高位作为分片号，
+  // 和分片内 unordered_map 使用的低位错开
+  uint64_t h = static_cast<uint64_t>(CacheKeyHash()(key)) * 0x9E3779B97F4A7C15ULL;
+  return shards_[h >> shardShift_];
+}
+
+void ShardedCacheLRU::erase(Shard& s, ListIt it) {
+  s.usedBytes -= it->bytes;
+  s.map.erase(it->key);
+  s.lru.erase(it);
+}
+
+// 调用方持有该分片的独占锁
+void ShardedCacheLRU::evictIfNeeded(Shard& s) {
+  // CLOCK 模式下每个条目最多被挪回一次队首，扫描次数有上界
+  size_t secondChances = clockRecency_ ? s.lru.size() : 0;
+  while (s.usedBytes > capPerShard_ && !s.lru.empty()) {
+    ListIt victim = std::prev(s.lru.end());
+    if (secondChances > 0 && victim->referenced.load(std::memory_order_relaxed)) {
+      --secondChances;
+      victim->referenced.store(false, std::memory_order_relaxed);
+      s.lru.splice(s.lru.begin(), s.lru, victim);
+      continue;
+    }
+    erase(s, victim);
+  }
+}
+
+CachedEntryPtr ShardedCacheLRU::get(const CacheKey& key) {
+  Shard& s = shardFor(key);
+  if (clockRecency_) {
+    std::shared_lock lock(s.mu);
+    auto it = s.map.find(key);
+    if (it == s.map.end()) return nullptr;
+    // 已经置位时不再写，避免热点条目的缓存行在各线程之间来回失效
+    if (!it->second->referenced.load(std::memory_order_relaxed)) {
+      it->second->referenced.store(true, std::memory_order_relaxed);
+    }
+    return it->second->entry;
+  }
+
+  std::unique_lock lock(s.mu);
+  auto it = s.map.find(key);
+  if (it == s.map.end()) return nullptr;
+  s.lru.splice(s.lru.begin(), s.lru, it->second);
+  return it->second->entry;
+}
+
+void ShardedCacheLRU::set(const CacheKey& key, CachedEntryPtr e) {
+  size_t sz = e->bytes();
+  if (sz > capPerShard_) return;
+
+  Shard& s = shardFor(key);
+  CachedEntryPtr old; // 被替换的旧条目在解锁之后释放
+  std::unique_lock lock(s.mu);
+  auto it = s.map.find(key);
+  if (it != s.map.end()) {
+    Node& node = *it->second;
+    s.usedBytes -= node.bytes;
+    old = std::move(node.entry);
+    node.entry = std::move(e);
+    node.bytes = sz;
+    s.usedBytes += sz;
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+  } else {
+    s.lru.emplace_front(key, std::move(e));
+    s.map.emplace(key, s.lru.begin());
+    s.usedBytes += sz;
+  }
+  evictIfNeeded(s);
+}
+
+void ShardedCacheLRU::del(const CacheKey& key) {
+  Shard& s = shardFor(key);
+  std::unique_lock lock(s.mu);
+  auto it = s.map.find(key);
+  if (it == s.map.end()) return;
+  erase(s, it->second);
+}
+
+void ShardedCacheLRU::purgePrefix(const std::string& prefix) {
+  // 前缀对应的键散落在所有分片里，逐个分片清理，任一时刻只持有一把锁
+  for (size_t i = 0; i < shardCount_; ++i) {
+    Shard& s = shards_[i];
+    std::unique_lock lock(s.mu);
+    for (auto it = s.lru.begin(); it != s.lru.end(); ) {
+      if (it->key.pathAndQuery.rfind(prefix, 0) == 0) {
+        auto next = std::next(it);
+        erase(s, it);
+        it = next;
+      } else {
+        ++it;
+      }
+    }
+  }
+}
@@ -0,0 +1,133 @@
+#include "http_cache/include/TinyLfuCache.h"
+
+using namespace http::cache;
+
+namespace {
+
+const size_t kAverageEntryBytes = 4096;
+
+uint64_t keyHash(const CacheKey& key) {
+  return static_cast<uint64_t>(CacheKeyHash()(key));
+}
+
+} // namespace
+
+TinyLfuCache::TinyLfuCache(size_t capBytes, size_t expectedEntries)
+  : windowCap_(capBytes / 100),
+    mainCap_(capBytes - windowCap_),
+    protectedCap_(mainCap_ / 5 * 4),
+    sketch_(expectedEntries ? expectedEntries : capBytes / kAverageEntryBytes) {}
+
+TinyLfuCache::List& TinyLfuCache::listOf(Region r) {
+  return r == kWindow ? window_ : (r == kProbation ? probation_ : protected_);
+}
+
+size_t& TinyLfuCache::bytesOf(Region r) {
+  return r == kWindow ? windowBytes_ : (r == kProbation ? probationBytes_ : protectedBytes_);
+}
+
+// 挪到 r 段的队首；splice 不会让迭代器失效，map_ 不用更新
+void TinyLfuCache::moveTo(ListIt it, Region r) {
+  bytesOf(it->region) -= it->bytes;
+  bytesOf(r) += it->bytes;
+  listOf(r).splice(listOf(r).begin(), listOf(it->region), it);
+  it->region = r;
+}
+
+void TinyLfuCache::erase(ListIt it) {
+  bytesOf(it->region) -= it->bytes;
+  map_.erase(it->key);
+  listOf(it->region).erase(it);
+}
+
+void TinyLfuCache::onHit(ListIt it) {
+  if (it->region == kProbation) {
+    moveTo(it, kProtected);
+    while (protectedBytes_ > protectedCap_ && protected_.size() > 1)
+      moveTo(std::prev(protected_.end()), kProbation);
+  } else {
+    moveTo(it, it->region);
+  }
+}
+
+// 调用方持有 mu_
+void TinyLfuCache::evictIfNeeded() {
+  while (windowBytes_ > windowCap_ && !window_.empty()) {
+    ListIt candidate = std::prev(window_.end());
+    moveTo(candidate, kProbation);
+
+    // 主区放不下时，候选者和 probation 队尾（probation 只剩候选者时换成 protected 队尾）逐个比频率，
+    // 候选者必须比每个被淘汰的条目都更常用
+    while (mainBytes() > mainCap_) {
+      ListIt victim = std::prev(probation_.end());
+      if (victim == candidate) {
+        if (protected_.empty()) break;
+        victim = std::prev(protected_.end());
+      }
+      if (sketch_.frequency(candidate->hash) > sketch_.frequency(victim->hash)) {
+        erase(victim);
+      } else {
+        erase(candidate);
+        break;
+      }
+    }
+  }
+
+  // 覆盖写入让已有条目变大时主区也可能超出，按 probation、protected 的顺序从队尾淘汰
+  while (mainBytes() > mainCap_) {
+    erase(std::prev(probation_.empty() ? protected_.end() : probation_.end()));
+  }
+}
+
+CachedEntryPtr TinyLfuCache::get(const CacheKey& key) {
+  uint64_t hash = keyHash(key);
+  std::lock_guard lock(mu_);
+  // 未命中也计入频率：之后写入时，准入比较看的就是这些请求
+  sketch_.increment(hash);
+  auto it = map_.find(key);
+  if (it == map_.end()) return nullptr;
+  onHit(it->second);
+  return it->second->entry;
+}
+
+void TinyLfuCache::set(const CacheKey& key, CachedEntryPtr e) {
+  size_t sz = e->bytes();
+  if (sz > mainCap_) return;
+
+  CachedEntryPtr old; // 被替换的旧条目在解锁之后释放
+  std::lock_guard lock(mu_);
+  auto it = map_.find(key);
+  if (it != map_.end()) {
+    Node& node = *it->second;
+    bytesOf(node.region) -= node.bytes;
+    old = std::move(node.entry);
+    node.entry = std::move(e);
+    node.bytes = sz;
+    bytesOf(node.region) += sz;
+    moveTo(it->second, node.region);
+  } else {
+    // 新条目总是先进窗口，准入在它离开窗口时才判断
+    window_.push_front(Node{key, std::move(e), sz, keyHash(key), kWindow});
+    windowBytes_ += sz;
+    map_.emplace(key, window_.begin());
+  }
+  evictIfNeeded();
+}
+
+void TinyLfuCache::del(const CacheKey& key) {
+  std::lock_guard lock(mu_);
+  auto it = map_.find(key);
+  if (it == map_.end()) return;
+  erase(it->second);
+}
+
+void TinyLfuCache::purgePrefix(const std::string& prefix) {
+  std::lock_guard lock(mu_);
+  for (List* list : {&window_, &probation_, &protected_}) {
+    for (auto it = list->begin(); it != list->end(); ) {
+      auto next = std::next(it);
+      if (it->key.pathAndQuery.rfind(prefix, 0) == 0) erase(it);
+      it = next;
+    }
+  }
+}